@@ -0,0 +1,52 @@
+// Auduino host, EEPROM is ordinary memory
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// EEMEM variables are plain globals, zero rather than erased at start.
+// Writes finish at once.
+
+#ifndef __HOST_AVR_EEPROM_H__
+#define __HOST_AVR_EEPROM_H__ 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define EEMEM
+
+inline bool eeprom_is_ready() {
+	return true;
+}
+
+inline uint8_t eeprom_read_byte(const uint8_t *addr) {
+	return *addr;
+}
+
+inline uint16_t eeprom_read_word(const uint16_t *addr) {
+	return *addr;
+}
+
+inline void eeprom_read_block(void *dst, const void *src, size_t n) {
+	memcpy(dst, src, n);
+}
+
+inline void eeprom_write_byte(uint8_t *addr, uint8_t value) {
+	*addr = value;
+}
+
+inline void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+	*addr = value;
+}
+
+inline void eeprom_update_word(uint16_t *addr, uint16_t value) {
+	*addr = value;
+}
+
+inline void eeprom_update_block(const void *src, void *dst, size_t n) {
+	memcpy(dst, src, n);
+}
+
+#endif
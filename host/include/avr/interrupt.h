@@ -0,0 +1,26 @@
+// Auduino host, interrupt control
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// The global interrupt flag is host state. sei() runs pending
+// interrupts at once, as the AVR does one instruction later.
+
+#ifndef __HOST_AVR_INTERRUPT_H__
+#define __HOST_AVR_INTERRUPT_H__ 1
+
+#include "host.h"
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+
+#define ISR(vector, ...) \
+	extern "C" void vector(); \
+	extern "C" void vector()
+
+#define sei() Host.enableInterrupts()
+#define cli() Host.disableInterrupts()
+
+#endif
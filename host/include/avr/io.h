@@ -0,0 +1,103 @@
+// Auduino host, ATmega328P registers in a host array
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// Only the registers and bits the firmware touches. They live at their
+// data space addresses in hostIo, host.cpp gives the timer, USART and
+// interrupt flags their behaviour.
+
+#ifndef __HOST_AVR_IO_H__
+#define __HOST_AVR_IO_H__ 1
+
+#include <stdint.h>
+
+extern volatile uint8_t hostIo[0x100];
+
+#define _SFR_MEM8(addr)  (hostIo[addr])
+#define _SFR_MEM16(addr) (*reinterpret_cast<volatile uint16_t *>(&hostIo[addr]))
+#define _BV(bit) (1 << (bit))
+
+#define PINB   _SFR_MEM8(0x23)
+#define DDRB   _SFR_MEM8(0x24)
+#define PORTB  _SFR_MEM8(0x25)
+#define PIND   _SFR_MEM8(0x29)
+#define DDRD   _SFR_MEM8(0x2A)
+#define PORTD  _SFR_MEM8(0x2B)
+#define TIFR1  _SFR_MEM8(0x36)
+#define TIFR2  _SFR_MEM8(0x37)
+#define SMCR   _SFR_MEM8(0x53)
+#define PRR    _SFR_MEM8(0x64)
+#define TIMSK1 _SFR_MEM8(0x6F)
+#define TIMSK2 _SFR_MEM8(0x70)
+#define TCCR1A _SFR_MEM8(0x80)
+#define TCCR1B _SFR_MEM8(0x81)
+#define TCNT1  _SFR_MEM16(0x84)
+#define OCR1A  _SFR_MEM16(0x88)
+#define TCCR2A _SFR_MEM8(0xB0)
+#define TCCR2B _SFR_MEM8(0xB1)
+#define TCNT2  _SFR_MEM8(0xB2)
+#define OCR2A  _SFR_MEM8(0xB3)
+#define OCR2B  _SFR_MEM8(0xB4)
+#define UCSR0A _SFR_MEM8(0xC0)
+#define UCSR0B _SFR_MEM8(0xC1)
+#define UCSR0C _SFR_MEM8(0xC2)
+#define UBRR0L _SFR_MEM8(0xC4)
+#define UBRR0H _SFR_MEM8(0xC5)
+#define UDR0   _SFR_MEM8(0xC6)
+
+// TIFR1, TIMSK1, TCCR1B
+#define TOV1   0
+#define OCF1A  1
+#define TOIE1  0
+#define OCIE1A 1
+#define CS10   0
+#define WGM12  3
+
+// TIFR2, TIMSK2, TCCR2A, TCCR2B
+#define TOV2   0
+#define TOIE2  0
+#define WGM20  0
+#define WGM21  1
+#define COM2B0 4
+#define COM2B1 5
+#define CS20   0
+#define CS21   1
+#define CS22   2
+
+// UCSR0A, UCSR0B
+#define U2X0   1
+#define DOR0   3
+#define FE0    4
+#define UDRE0  5
+#define TXC0   6
+#define RXC0   7
+#define TXEN0  3
+#define RXEN0  4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+
+// SMCR
+#define SE     0
+#define SM0    1
+#define SM1    2
+#define SM2    3
+
+// PRR
+#define PRADC    0
+#define PRUSART0 1
+#define PRSPI    2
+#define PRTIM1   3
+#define PRTIM0   5
+#define PRTIM2   6
+#define PRTWI    7
+
+// Vector names as in avr-libc, host.cpp calls them
+#define TIMER1_COMPA_vect __vector_11
+#define TIMER2_OVF_vect   __vector_9
+#define USART_RX_vect     __vector_18
+
+#endif
@@ -0,0 +1,21 @@
+// Auduino host, flash is ordinary memory
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+
+#ifndef __HOST_AVR_PGMSPACE_H__
+#define __HOST_AVR_PGMSPACE_H__ 1
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+#define memcpy_P memcpy
+
+#endif
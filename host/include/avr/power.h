@@ -0,0 +1,21 @@
+// Auduino host, power reduction bits only
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+
+#ifndef __HOST_AVR_POWER_H__
+#define __HOST_AVR_POWER_H__ 1
+
+#include <avr/io.h>
+
+#define power_adc_disable()    (PRR |= _BV(PRADC))
+#define power_spi_disable()    (PRR |= _BV(PRSPI))
+#define power_twi_disable()    (PRR |= _BV(PRTWI))
+#define power_timer0_disable() (PRR |= _BV(PRTIM0))
+#define power_timer1_disable() (PRR |= _BV(PRTIM1))
+#define power_timer2_disable() (PRR |= _BV(PRTIM2))
+#define power_usart0_disable() (PRR |= _BV(PRUSART0))
+
+#endif
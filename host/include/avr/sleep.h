@@ -0,0 +1,29 @@
+// Auduino host, sleep skips virtual time to the next interrupt
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+
+#ifndef __HOST_AVR_SLEEP_H__
+#define __HOST_AVR_SLEEP_H__ 1
+
+#include <avr/io.h>
+#include "host.h"
+
+#define SLEEP_MODE_IDLE       0
+#define SLEEP_MODE_ADC        _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN   _BV(SM1)
+#define SLEEP_MODE_PWR_SAVE   (_BV(SM0) | _BV(SM1))
+
+#define set_sleep_mode(mode) \
+	(SMCR = (SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode))
+#define sleep_enable()  (SMCR |= _BV(SE))
+#define sleep_disable() (SMCR &= ~_BV(SE))
+// SLEEP is a no-op without SE
+#define sleep_cpu() \
+	do { if (SMCR & _BV(SE)) Host.sleep(); } while (0)
+#define sleep_mode() \
+	do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+
+#endif
@@ -0,0 +1,85 @@
+// Auduino host, a virtual ATmega328P for running the firmware on Linux
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// Functional, not cycle accurate: firmware code takes no virtual time.
+// Time moves in run() and sleep() only, by whole events: a Timer2
+// overflow every 510 cycles and a MIDI byte slot every byte time. At
+// each event the flags are raised as the hardware would, then pending
+// interrupts run if enabled, Timer2 first as by vector number. Interrupt
+// timing belongs to simulavr, see make jitter.
+
+#ifndef __HOST_H__
+#define __HOST_H__ 1
+
+#include <stdint.h>
+
+// MIDI stream slot without a byte, as in sim.h and tools/bridge.py
+#define HOST_IDLE 0xFD
+// Cycles per Timer2 overflow, 8bit phase correct PWM
+#define HOST_SAMPLE_CYCLES 510
+
+class _Host {
+	uint64_t nextSample;
+	uint64_t nextSlot;
+	bool enabled;
+	bool inputDone;
+	// at least one interrupt ran since the flag was cleared
+	bool woken;
+
+	void sample();
+	void slot();
+	void dispatch();
+	uint64_t nextEvent() const;
+	void step();
+
+public:
+	typedef int (*InputPtr)();
+	typedef void (*OutputPtr)(uint8_t);
+
+	// since reset
+	uint64_t cycles;
+	uint16_t slotCycles;
+	// run() and sleep() stop here, set by the end of input
+	uint64_t end;
+	// cycles to run on after the input ends, for release tails
+	uint64_t tail;
+
+	/**
+	 * Called once per MIDI byte time for the byte on the wire,
+	 * HOST_IDLE for none, -1 at the end of input
+	 */
+	InputPtr input = nullptr;
+	/**
+	 * Called once per sample period with the PWM value latched for it,
+	 * 128 while Timer2 is stopped
+	 */
+	OutputPtr output = nullptr;
+
+	// bytes lost because the receive interrupt was held off
+	uint32_t lostBytes;
+
+	/**
+	 * Registers to their reset values, interrupts off.
+	 */
+	void reset(uint32_t baudRate);
+	void enableInterrupts();
+	void disableInterrupts();
+	bool interruptsEnabled() const;
+	/**
+	 * Move virtual time to until, running interrupts on the way.
+	 */
+	void run(uint64_t until);
+	/**
+	 * Move virtual time until an interrupt has run, or to end.
+	 */
+	void sleep();
+	bool done() const;
+};
+
+extern _Host Host;
+
+#endif
@@ -0,0 +1,39 @@
+// Auduino host, ATOMIC_BLOCK on the host interrupt flag
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+
+#ifndef __HOST_UTIL_ATOMIC_H__
+#define __HOST_UTIL_ATOMIC_H__ 1
+
+#include "host.h"
+
+#define ATOMIC_RESTORESTATE false
+#define ATOMIC_FORCEON      true
+
+// Leaving the block by any path restores the flag, pending interrupts
+// run then
+class HostAtomic {
+	bool restore;
+
+public:
+	bool once = true;
+
+	explicit HostAtomic(bool forceOn)
+		: restore(forceOn || Host.interruptsEnabled()) {
+		Host.disableInterrupts();
+	}
+
+	~HostAtomic() {
+		if (restore) {
+			Host.enableInterrupts();
+		}
+	}
+};
+
+#define ATOMIC_BLOCK(type) \
+	for (HostAtomic _atomic(type); _atomic.once; _atomic.once = false)
+
+#endif
@@ -0,0 +1,245 @@
+// Auduino bench, host timings of the engine building blocks
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// Usage:
+//   auduino-bench [-n calls] [-r repeats] [-o output.json]
+//
+// Times each operation over batches of calls, inputs drawn from a fixed
+// pseudo random table so nothing folds to a constant. ns per call is
+// the median of the repeats, the minimum is kept for noisy machines.
+// Figures include the loop and one input read, the same for every
+// entry, so compare entries with each other and runs with runs rather
+// than with AVR cycle counts. State stays in memory between calls, as
+// in the voices array, so a chain of calls on one Phase or Env costs a
+// load and a store each.
+//
+// voice_render is one whole sample of one voice, its calls per second
+// against the sample rate F_CPU / 510 is the x_real_time of the report.
+//
+// mapMidi and mapPentatonic are gone, the scale quantiser replaced
+// them: map_scale_* time mapScale() with a chromatic and a pentatonic
+// scale, tuning_interpolate the smooth controller mapping.
+//
+// Output is a single JSON object, for trend tracking:
+//
+//   { "f_cpu": 16000000, "sample_rate": 31372.5, "calls": 1048576,
+//     "repeats": 9, "benchmarks": [ { "name": "phase_increment",
+//     "ns_per_call": 3.194, "ns_per_call_min": 3.062,
+//     "calls_per_second": 3.131e+08 }, ... ], "x_real_time": 7441.4 }
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "voice.h"
+#include "tuning.h"
+#include "scale.h"
+#include "mapping.h"
+
+#define BENCH_RATE (static_cast<double>(F_CPU) / 510)
+
+// Power of two
+#define BENCH_INPUTS 4096
+
+static uint16_t inputs[BENCH_INPUTS];
+
+// The compiler must assume value was read and changed
+template <typename T>
+static inline void keep(T &value) {
+	asm volatile ("" : "+r" (value));
+}
+
+struct Result {
+	const char *name;
+	double ns;
+	double nsMin;
+};
+
+static uint32_t calls = 1 << 20;
+static unsigned repeats = 9;
+static std::vector<Result> results;
+
+static double now() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+template <typename Body>
+static double bench(const char *name, Body body) {
+	std::vector<double> times;
+	uint32_t count = calls;
+
+	// One unmeasured batch for caches and clocks
+	for (unsigned repeat = 0; repeat <= repeats; repeat++) {
+		double start = now();
+
+		for (uint32_t i = 0; i < count; i++) {
+			body(inputs[i & (BENCH_INPUTS - 1)], i);
+		}
+
+		double elapsed = now() - start;
+
+		if (repeat) {
+			times.push_back(elapsed / count);
+		}
+	}
+
+	std::sort(times.begin(), times.end());
+	results.push_back({ name, times[times.size() / 2], times[0] });
+
+	return times[times.size() / 2];
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-n calls] [-r repeats] [-o output.json]\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	const char *path = nullptr;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:o:")) != -1) {
+		switch (opt) {
+			case 'n': calls = atol(optarg); break;
+			case 'r': repeats = atoi(optarg); break;
+			case 'o': path = optarg; break;
+			default: usage(argv[0]);
+		}
+	}
+
+	if (optind != argc || calls < 1 || repeats < 1) {
+		usage(argv[0]);
+	}
+
+	// Same inputs every run
+	uint32_t seed = 1;
+
+	for (auto &input : inputs) {
+		seed = seed * 1103515245 + 12345;
+		input = seed >> 16;
+	}
+
+	Tuning.begin();
+
+	Phase phase = {};
+	phase.setInc(Tuning.inc(60));
+
+	bench("phase_increment", [&] (uint16_t, uint32_t) {
+		++phase;
+		keep(phase.acc);
+	});
+
+	bench("phase_modulate", [&] (uint16_t input, uint32_t) {
+		phase.modulate(input & 0x3fff);
+		keep(phase.modInc);
+	});
+
+	Env env = { 0x7fff, 1, 0 };
+
+	bench("env_tick", [&] (uint16_t, uint32_t i) {
+		// Restart before the integer envelope stalls
+		if (!(i & 0x3ff)) {
+			env.reset();
+		}
+
+		env.tick();
+		keep(env.amp);
+	});
+
+	Grain grain = {};
+
+	bench("grain_get_sample", [&] (uint16_t input, uint32_t) {
+		grain.phase.acc = input;
+		grain.env.amp = input >> 1;
+		uint16_t sample = grain.getSample();
+		keep(sample);
+	});
+
+	grain.reset();
+	grain.phase.setInc(Tuning.interpolate(90 << 7));
+	grain.env.decay = 8;
+
+	bench("grain_render", [&] (uint16_t, uint32_t i) {
+		if (!(i & 0xff)) {
+			grain.reset();
+		}
+
+		uint16_t sample = grain.render();
+		keep(sample);
+	});
+
+	bench("map_phase_inc", [&] (uint16_t input, uint32_t) {
+		uint16_t inc = mapPhaseInc(input & 0x3ff);
+		keep(inc);
+	});
+
+	Scale.set(SCALE_CHROMATIC, 0);
+
+	bench("map_scale_chromatic", [&] (uint16_t input, uint32_t) {
+		uint16_t inc = mapScale(input & 0x3ff);
+		keep(inc);
+	});
+
+	// Pentatonic D, E, G, A, B as in auduino.cpp
+	Scale.set(SCALE_PENTATONIC, 7);
+
+	bench("map_scale_pentatonic", [&] (uint16_t input, uint32_t) {
+		uint16_t inc = mapScale(input & 0x3ff);
+		keep(inc);
+	});
+
+	bench("tuning_interpolate", [&] (uint16_t input, uint32_t) {
+		uint16_t inc = Tuning.interpolate(input & 0x3fff);
+		keep(inc);
+	});
+
+	// As sweep.cpp renders, a held note with audible grains
+	Voice voice;
+	memset(&voice, 0, sizeof(voice));
+	voice.grains[0].phase.setInc(Tuning.interpolate(90 << 7));
+	voice.grains[1].phase.setInc(Tuning.interpolate(100 << 7));
+	voice.grains[0].env.decay = 2;
+	voice.grains[1].env.decay = 4;
+	voice.note.gate = Note::OPEN;
+	voice.env.amp = 127 << 8;
+	voice.sync[0].setInc(Tuning.inc(60 - 24));
+	voice.sync[1].setInc(Tuning.inc(60 - 17));
+
+	double voiceNs = bench("voice_render", [&] (uint16_t, uint32_t) {
+		int16_t sample = voice.render(QUALITY_FULL);
+		keep(sample);
+	});
+
+	FILE *out = path ? fopen(path, "w") : stdout;
+
+	if (!out) {
+		perror(path);
+		return 1;
+	}
+
+	fprintf(out, "{\n  \"f_cpu\": %lu,\n  \"sample_rate\": %.1f,\n"
+		"  \"calls\": %u,\n  \"repeats\": %u,\n  \"benchmarks\": [\n",
+		static_cast<unsigned long>(F_CPU), BENCH_RATE, calls, repeats);
+
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result &result = results[i];
+
+		fprintf(out, "    { \"name\": \"%s\", \"ns_per_call\": %.3f, "
+			"\"ns_per_call_min\": %.3f, \"calls_per_second\": %.4g }%s\n",
+			result.name, result.ns, result.nsMin, 1e9 / result.ns,
+			i + 1 < results.size() ? "," : "");
+	}
+
+	fprintf(out, "  ],\n  \"x_real_time\": %.1f\n}\n", 1e9 / voiceNs / BENCH_RATE);
+
+	return out != stdout && fclose(out) ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+// Auduino host, a virtual ATmega328P for running the firmware on Linux
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include "host.h"
+
+volatile uint8_t hostIo[0x100];
+
+_Host Host;
+
+extern "C" void TIMER2_OVF_vect() __attribute__((weak));
+extern "C" void USART_RX_vect() __attribute__((weak));
+
+void _Host::reset(uint32_t baudRate) {
+	for (auto &reg : hostIo) {
+		reg = 0;
+	}
+
+	UCSR0A = _BV(UDRE0);
+
+	cycles = 0;
+	nextSample = HOST_SAMPLE_CYCLES;
+	slotCycles = F_CPU * 10 / baudRate;
+	nextSlot = slotCycles;
+	end = UINT64_MAX;
+	enabled = false;
+	inputDone = false;
+	woken = false;
+	lostBytes = 0;
+}
+
+void _Host::enableInterrupts() {
+	enabled = true;
+	dispatch();
+}
+
+void _Host::disableInterrupts() {
+	enabled = false;
+}
+
+bool _Host::interruptsEnabled() const {
+	return enabled;
+}
+
+bool _Host::done() const {
+	return cycles >= end;
+}
+
+// The compare value was latched at TOP, half way through the period
+void _Host::sample() {
+	bool running = TCCR2B & (_BV(CS20) | _BV(CS21) | _BV(CS22));
+
+	if (output) {
+		output(running ? OCR2B : 128);
+	}
+
+	if (running) {
+		TIFR2 |= _BV(TOV2);
+	}
+}
+
+// One byte deep, the second byte of the hardware FIFO is not modelled
+void _Host::slot() {
+	int data = !inputDone && input ? input() : -1;
+
+	if (data < 0) {
+		if (!inputDone) {
+			inputDone = true;
+			end = cycles + tail;
+		}
+		return;
+	}
+
+	if (data == HOST_IDLE || !(UCSR0B & _BV(RXEN0))) {
+		return;
+	}
+
+	if (UCSR0A & _BV(RXC0)) {
+		UCSR0A |= _BV(DOR0);
+		lostBytes++;
+	} else {
+		UDR0 = data;
+		UCSR0A |= _BV(RXC0);
+	}
+}
+
+// Lower vector number first, as the AVR does. An interrupt that enables
+// interrupts again lets the others in through enableInterrupts().
+void _Host::dispatch() {
+	while (enabled) {
+		if ((TIFR2 & _BV(TOV2)) && (TIMSK2 & _BV(TOIE2)) && TIMER2_OVF_vect) {
+			TIFR2 &= ~_BV(TOV2);
+			enabled = false;
+			TIMER2_OVF_vect();
+		} else if ((UCSR0A & _BV(RXC0)) && (UCSR0B & _BV(RXCIE0)) && USART_RX_vect) {
+			enabled = false;
+			USART_RX_vect();
+			// the interrupt read UDR0
+			UCSR0A &= ~(_BV(RXC0) | _BV(DOR0));
+		} else {
+			break;
+		}
+
+		enabled = true;
+		woken = true;
+	}
+}
+
+uint64_t _Host::nextEvent() const {
+	return nextSample < nextSlot ? nextSample : nextSlot;
+}
+
+void _Host::step() {
+	cycles = nextEvent();
+
+	if (cycles == nextSample) {
+		nextSample += HOST_SAMPLE_CYCLES;
+		sample();
+	}
+	if (cycles == nextSlot) {
+		nextSlot += slotCycles;
+		slot();
+	}
+
+	// The transmitter drains at once
+	UCSR0A |= _BV(UDRE0);
+	dispatch();
+}
+
+void _Host::run(uint64_t until) {
+	if (until > end) {
+		until = end;
+	}
+
+	while (nextEvent() <= until) {
+		step();
+	}
+
+	if (cycles < until) {
+		cycles = until;
+	}
+}
+
+// Interrupts run by the sei() just before do not count, the AVR would
+// wake from them at once. That costs one event, not a missed wake up.
+void _Host::sleep() {
+	if (!enabled) {
+		fprintf(stderr, "host: sleep with interrupts disabled never wakes\n");
+		abort();
+	}
+
+	woken = false;
+
+	while (!woken && cycles < end) {
+		step();
+	}
+}
@@ -0,0 +1,259 @@
+// Auduino host driver, runs setup() and loop() against the virtual MCU
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+// 17 Oct 2026: Live MIDI input, block output, 16bit samples
+//
+// Usage:
+//   auduino-host [-m] [-t tail] [-b baud] [-B block] [-w 8|16] input output
+//
+// Input is the timed byte stream of tools/bridge.py stream, or with -m
+// plain MIDI bytes played as they arrive, e.g. from a raw MIDI device.
+// Output is 8bit unsigned or 16bit signed little endian samples at
+// F_CPU / 510, written in blocks of -B samples. "-" for stdin or stdout:
+//
+//   auduino-host -m -w 16 /dev/snd/midiC1D0 - | aplay -f S16_LE -r 31373
+//
+// With -m virtual time is held to the wall clock. Bytes are read
+// between blocks and wait in a small ring for their slot on the
+// virtual wire, so latency is one block plus whatever the reader of
+// the output buffers. Nothing is allocated once running.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "host.h"
+#include "midi.h"
+
+extern void setup();
+extern void loop();
+extern void serialEventRun() __attribute__((weak));
+
+// Virtual cost of one pass of loop() that did not sleep
+#define HOST_LOOP_CYCLES 256
+
+#define HOST_MAX_BLOCK 4096
+
+// Live input waiting for the wire, power of two
+#define HOST_LIVE_BUFFER 256
+
+static int in;
+static int out;
+static bool live;
+static bool wide;
+
+static uint8_t block[HOST_MAX_BLOCK * 2];
+static size_t blockSize = 64;
+static size_t blockUsed;
+
+static uint8_t liveBuffer[HOST_LIVE_BUFFER];
+static uint16_t liveHead;
+static uint16_t liveTail;
+static bool inputEnded;
+
+static struct timespec start;
+
+static void fail(const char *what) {
+	perror(what);
+	exit(1);
+}
+
+// Timed stream, one byte per slot
+static int readStream() {
+	static uint8_t buffer[4096];
+	static size_t used;
+	static size_t size;
+
+	if (used == size) {
+		ssize_t n;
+
+		while ((n = read(in, buffer, sizeof(buffer))) < 0 && errno == EINTR);
+
+		if (n < 0) {
+			fail("read");
+		}
+		if (n == 0) {
+			return -1;
+		}
+
+		used = 0;
+		size = n;
+	}
+
+	return buffer[used++];
+}
+
+// As much as the ring takes without blocking
+static void pollLive() {
+	while (!inputEnded && static_cast<uint16_t>(liveHead - liveTail) < HOST_LIVE_BUFFER) {
+		uint8_t data;
+		ssize_t n = read(in, &data, 1);
+
+		if (n == 0) {
+			inputEnded = true;
+		} else if (n < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			if (errno != EINTR) {
+				fail("read");
+			}
+		} else {
+			liveBuffer[liveHead++ & (HOST_LIVE_BUFFER - 1)] = data;
+		}
+	}
+}
+
+static int readLive() {
+	if (liveHead != liveTail) {
+		return liveBuffer[liveTail++ & (HOST_LIVE_BUFFER - 1)];
+	}
+
+	return inputEnded ? -1 : HOST_IDLE;
+}
+
+// Sleep until the wall clock reaches the virtual time of the block start
+static void pace(uint64_t cycles) {
+	uint64_t ns = cycles * 1000000000ULL / F_CPU;
+	struct timespec until = start;
+
+	until.tv_sec += ns / 1000000000ULL;
+	until.tv_nsec += ns % 1000000000ULL;
+
+	if (until.tv_nsec >= 1000000000L) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000L;
+	}
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR);
+}
+
+static void writeBlock() {
+	size_t size = blockUsed * (wide ? 2 : 1);
+	size_t done = 0;
+
+	while (done < size) {
+		ssize_t n = write(out, block + done, size - done);
+
+		if (n < 0 && errno != EINTR) {
+			fail("write");
+		}
+		if (n > 0) {
+			done += n;
+		}
+	}
+
+	blockUsed = 0;
+}
+
+static void writeOutput(uint8_t sample) {
+	if (wide) {
+		int16_t value = (sample - 128) << 8;
+		block[2 * blockUsed] = value;
+		block[2 * blockUsed + 1] = value >> 8;
+	} else {
+		block[blockUsed] = sample;
+	}
+
+	if (++blockUsed < blockSize) {
+		return;
+	}
+
+	writeBlock();
+
+	if (live) {
+		pace(Host.cycles - blockSize * HOST_SAMPLE_CYCLES);
+		pollLive();
+	}
+}
+
+static int openFile(const char *path, int flags, int std) {
+	if (!strcmp(path, "-")) {
+		return std;
+	}
+
+	int fd = ::open(path, flags, 0644);
+
+	if (fd < 0) {
+		fail(path);
+	}
+
+	return fd;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-m] [-t tail] [-b baud] [-B block] [-w 8|16] "
+		"input output\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	double tail = 2.0;
+	uint32_t baud = MIDI_BAUD_RATE;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "mt:b:B:w:")) != -1) {
+		switch (opt) {
+			case 'm': live = true; break;
+			case 't': tail = atof(optarg); break;
+			case 'b': baud = atol(optarg); break;
+			case 'B': blockSize = atol(optarg); break;
+			case 'w': wide = atoi(optarg) == 16; break;
+			default: usage(argv[0]);
+		}
+	}
+
+	if (argc - optind != 2 || blockSize < 1 || blockSize > HOST_MAX_BLOCK) {
+		usage(argv[0]);
+	}
+
+	in = openFile(argv[optind], O_RDONLY, STDIN_FILENO);
+	out = openFile(argv[optind + 1], O_WRONLY | O_CREAT | O_TRUNC, STDOUT_FILENO);
+
+	if (live && fcntl(in, F_SETFL, fcntl(in, F_GETFL) | O_NONBLOCK) < 0) {
+		fail("fcntl");
+	}
+
+	Host.reset(baud);
+	Host.tail = tail * F_CPU;
+	Host.input = live ? readLive : readStream;
+	Host.output = writeOutput;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// As runtime.cpp
+	setup();
+	Host.enableInterrupts();
+
+	while (!Host.done()) {
+		loop();
+
+		if (serialEventRun) {
+			serialEventRun();
+		}
+
+		Host.run(Host.cycles + HOST_LOOP_CYCLES);
+	}
+
+	if (blockUsed) {
+		writeBlock();
+	}
+
+	struct timespec stop;
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	double simulated = static_cast<double>(Host.cycles) / F_CPU;
+	double elapsed = stop.tv_sec - start.tv_sec + (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+	fprintf(stderr, "%.2fs simulated in %.2fs, %.0fx real time, %u bytes lost\n",
+		simulated, elapsed, elapsed > 0 ? simulated / elapsed : 0.0,
+		static_cast<unsigned>(Host.lostBytes));
+
+	return 0;
+}
@@ -0,0 +1,421 @@
+// Auduino reference, double precision model of the voice and a report of
+// the error each fixed point shortcut of the firmware engine adds
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// Usage:
+//   auduino-reference [-l length] [-r release] [pitch] [envelope] [snr]
+//
+// Sections are printed in that order, all of them by default.
+//
+// pitch     Every MIDI note of the tuning table against equal temperament.
+//           The table is computed for 31250Hz, the audio interrupt runs at
+//           F_CPU / 510, so the error is split into increment rounding
+//           and sample rate. The last columns show a table computed for
+//           the real rate.
+//
+// envelope  Env::tick() against exact exponential decay, for grain
+//           decays (divider 0, from 0x7fff) and release settings (from
+//           full velocity). Times to -24dB, RMS error in dB while the
+//           exact curve is above -48dB, and where the integer envelope
+//           stops: "cut" drops to zero because of the divider, "stall"
+//           stops decaying because value() * decay rounds to zero.
+//
+// snr       The voice of voice.h rendered in doubles, with each shortcut
+//           switched on alone and all together, and the firmware Voice
+//           itself. Every render uses the same integer phase increments,
+//           pitch is the business of the first section:
+//
+//             fold   8bit triangle from phase.acc >> 7 and ~ in getSample()
+//             decay  integer Env::tick(), value() is amp >> 8
+//             scale  the >> 7 to 8bit after the grain sum, which wraps,
+//                    and the >> 8 to the PWM value
+//
+//           SNR is in PWM steps, signal power is the reference with its
+//           DC removed. "all" must match the firmware sample for sample,
+//           a mismatch means this model no longer describes voice.h.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "voice.h"
+#include "tuning.h"
+
+#define REFERENCE_RATE (static_cast<double>(F_CPU) / 510)
+
+// Rate the tuning table is computed for, see tuning.cpp
+#define TABLE_RATE 31250.0
+
+enum Shortcut {
+	SHORTCUT_FOLD = 1,
+	SHORTCUT_DECAY = 2,
+	SHORTCUT_SCALE = 4,
+	SHORTCUT_ALL = 7,
+};
+
+static const int8_t syncTranspose[2] = { -24, -17 };
+
+static double noteFrequency(double note) {
+	return pow(2.0, (note - 69) / 12.0) * 440.0;
+}
+
+static double cents(double ratio) {
+	return 1200.0 * log2(ratio);
+}
+
+static double decibels(double ratio) {
+	return 20.0 * log10(ratio);
+}
+
+static void printPitch() {
+	double rate = REFERENCE_RATE;
+	double worst[2] = { 0, 0 };
+
+	printf("# pitch, table for %.0fHz, audio at %.2fHz, rate error %+.2f cents\n",
+		TABLE_RATE, rate, cents(rate / TABLE_RATE));
+	printf("# note        Hz    inc  round   rate  total |    inc  total\n");
+
+	for (int note = 0; note < 128; note++) {
+		double ideal = noteFrequency(note);
+		uint16_t inc = Tuning.inc(note);
+		uint16_t fixedInc = lround(ideal * 65536 / rate);
+
+		double round = inc ? cents(inc * TABLE_RATE / 65536 / ideal) : -INFINITY;
+		double total = inc ? cents(inc * rate / 65536 / ideal) : -INFINITY;
+		double fixed = fixedInc ? cents(fixedInc * rate / 65536 / ideal) : -INFINITY;
+
+		printf("%6d %9.3f %6u %+6.2f %+6.2f %+6.2f | %6u %+6.2f\n",
+			note, ideal, inc, round, total - round, total, fixedInc, fixed);
+
+		// The lowest notes are a few steps of increment, see the table
+		if (note >= 24) {
+			worst[0] = fmax(worst[0], fabs(total));
+			worst[1] = fmax(worst[1], fabs(fixed));
+		}
+	}
+
+	printf("# worst from note 24 up: %.2f cents, %.2f cents with a table for %.2fHz\n\n",
+		worst[0], worst[1], rate);
+}
+
+static void printEnvelope(uint16_t start, uint8_t decay, uint8_t divider) {
+	Env env = { start, decay, divider };
+	double amp = start;
+	double k = decay / 256.0 / (1 << divider);
+
+	double reference24 = -1, fixed24 = -1;
+	double squared = 0;
+	uint32_t counted = 0;
+	const char *end = "-";
+	double endLevel = 0;
+
+	// Long enough for the slowest setting to pass -48dB, every integer
+	// envelope ends in a cut or a stall before that
+	for (uint32_t n = 0; n < 60 * REFERENCE_RATE; n++) {
+		double reference = decibels(amp / start);
+		double fixed = env.amp ? decibels(static_cast<double>(env.amp) / start) : -96;
+
+		if (reference24 < 0 && reference <= -24) {
+			reference24 = n;
+		}
+		if (fixed24 < 0 && fixed <= -24) {
+			fixed24 = n;
+		}
+		if (reference > -48) {
+			squared += (fixed - reference) * (fixed - reference);
+			counted++;
+		} else if (*end != '-') {
+			break;
+		}
+
+		uint16_t before = env.amp;
+
+		env.tick();
+		amp -= amp * k;
+
+		if (*end == '-' && env.amp == before) {
+			end = env.amp ? "stall" : "cut";
+			endLevel = fixed;
+		} else if (*end == '-' && !env.amp) {
+			end = "cut";
+			endLevel = fixed;
+		}
+	}
+
+	printf("%6u %7u %10.1f %10.1f %7.2f  %s",
+		decay, divider, reference24 * 1000 / REFERENCE_RATE,
+		fixed24 < 0 ? NAN : fixed24 * 1000 / REFERENCE_RATE,
+		sqrt(squared / counted), end);
+
+	if (*end != '-') {
+		printf(" at %.1fdB", endLevel);
+	}
+
+	printf("\n");
+}
+
+static void printEnvelopes() {
+	static const uint8_t grainDecays[] = { 1, 2, 4, 8, 16, 32, 64, 127 };
+	static const uint8_t release[][2] = {
+		{ 1, 0 }, { 1, 4 }, { 1, 7 }, { 16, 4 }, { 127, 4 }, { 127, 7 },
+	};
+
+	printf("# envelope, grain from 0x7fff\n");
+	printf("# decay divider exact-24ms fixed-24ms rms(dB)  end\n");
+
+	for (uint8_t decay : grainDecays) {
+		printEnvelope(0x7fff, decay, 0);
+	}
+
+	printf("# envelope, release from velocity 127\n");
+	printf("# decay divider exact-24ms fixed-24ms rms(dB)  end\n");
+
+	for (auto &setting : release) {
+		printEnvelope(127 << 8, setting[0], setting[1]);
+	}
+
+	printf("\n");
+}
+
+// Voice::render() with the shortcuts that are not selected done in doubles
+struct Model {
+	unsigned shortcuts;
+	bool open;
+	Phase sync[2];
+	Phase phase[2];
+	// amp in Env units, 0x7fff full
+	Env grainEnv[2];
+	double grainAmp[2];
+	Env env;
+	double envAmp;
+
+	void start(const Voice &voice, unsigned selected) {
+		shortcuts = selected;
+		open = true;
+
+		for (int i = 0; i < 2; i++) {
+			sync[i] = voice.sync[i];
+			phase[i] = voice.grains[i].phase;
+			grainEnv[i] = voice.grains[i].env;
+			grainAmp[i] = grainEnv[i].amp;
+		}
+
+		env = voice.env;
+		envAmp = env.amp;
+	}
+
+	double wave(uint16_t acc) const {
+		if (shortcuts & SHORTCUT_FOLD) {
+			uint8_t value = acc >> 7;
+			if (acc & 0x8000) value = ~value;
+			return value;
+		}
+
+		return (acc < 0x8000 ? acc : 0x10000 - acc) / 128.0;
+	}
+
+	double level(const Env &fixed, double amp) const {
+		return shortcuts & SHORTCUT_DECAY ? fixed.value() : amp / 256;
+	}
+
+	void tick(Env &fixed, double &amp) {
+		if (shortcuts & SHORTCUT_DECAY) {
+			fixed.tick();
+		} else {
+			amp -= amp / 256 * fixed.decay / (1 << fixed.divider);
+		}
+	}
+
+	// Centered, in PWM steps
+	double render() {
+		++sync[0];
+		++sync[1];
+
+		for (int i = 0; i < 2; i++) {
+			if (sync[i].hasOverflowed()) {
+				phase[i].reset();
+				grainEnv[i].reset();
+				grainAmp[i] = grainEnv[i].amp;
+			}
+		}
+
+		double sum = 0;
+
+		for (int i = 0; i < 2; i++) {
+			++phase[i];
+			sum += wave(phase[i].acc) * level(grainEnv[i], grainAmp[i]);
+			tick(grainEnv[i], grainAmp[i]);
+		}
+
+		if (!open) {
+			tick(env, envAmp);
+		}
+
+		double scaled = shortcuts & SHORTCUT_SCALE
+			? static_cast<uint8_t>(static_cast<uint16_t>(floor(sum)) >> 7) - 128
+			: sum / 128 - 128;
+		double output = scaled * 2 * (1 + level(env, envAmp));
+
+		return shortcuts & SHORTCUT_SCALE ? floor(output / 256) : output / 256;
+	}
+};
+
+struct SnrPatch {
+	const char *name;
+	uint8_t grain[2];
+	uint8_t decay[2];
+};
+
+static const SnrPatch snrPatches[] = {
+	{ "soft",   { 40, 50 },  { 8, 12 } },
+	{ "bright", { 90, 100 }, { 2, 4 } },
+	{ "long",   { 64, 70 },  { 1, 1 } },
+	{ "short",  { 64, 96 },  { 64, 127 } },
+};
+
+static const uint8_t snrNotes[] = { 36, 60, 84 };
+
+static const unsigned snrShortcuts[] = {
+	SHORTCUT_FOLD, SHORTCUT_DECAY, SHORTCUT_SCALE, SHORTCUT_ALL,
+};
+
+#define SNR_RENDERS (sizeof(snrShortcuts) / sizeof(snrShortcuts[0]) + 1)
+
+static double snr(double signal, double noise) {
+	return noise > 0 ? 10 * log10(signal / noise) : INFINITY;
+}
+
+static void printSnr(double length, double release) {
+	uint32_t held = length * REFERENCE_RATE;
+	uint32_t total = held + static_cast<uint32_t>(release * REFERENCE_RATE);
+	bool matches = true;
+
+	printf("# snr(dB), %.2fs held, %.2fs released, velocity 127\n", length, release);
+	printf("# patch  note    fold   decay   scale     all  firmware\n");
+
+	for (auto &patch : snrPatches) {
+		for (uint8_t note : snrNotes) {
+			Voice voice;
+			memset(&voice, 0, sizeof(voice));
+
+			for (int i = 0; i < 2; i++) {
+				voice.grains[i].phase.setInc(Tuning.interpolate(patch.grain[i] << 7));
+				voice.grains[i].env.decay = patch.decay[i];
+				voice.sync[i].setInc(Tuning.inc(note, syncTranspose[i]));
+			}
+
+			voice.note.gate = Note::OPEN;
+			voice.env.amp = 127 << 8;
+			voice.env.decay = 1;
+			voice.env.divider = 4;
+
+			Model reference, models[SNR_RENDERS - 1];
+
+			reference.start(voice, 0);
+
+			for (size_t i = 0; i < SNR_RENDERS - 1; i++) {
+				models[i].start(voice, snrShortcuts[i]);
+			}
+
+			double sum = 0, squared = 0;
+			double noise[SNR_RENDERS] = {};
+
+			for (uint32_t n = 0; n < total; n++) {
+				if (n == held) {
+					voice.note.gate = Note::CLOSED;
+					reference.open = false;
+
+					for (auto &model : models) {
+						model.open = false;
+					}
+				}
+
+				double exact = reference.render();
+				sum += exact;
+				squared += exact * exact;
+
+				double rendered[SNR_RENDERS];
+
+				for (size_t i = 0; i < SNR_RENDERS - 1; i++) {
+					rendered[i] = models[i].render();
+				}
+
+				rendered[SNR_RENDERS - 1] = voice.render(QUALITY_FULL) >> 8;
+
+				if (rendered[SNR_RENDERS - 1] != rendered[SNR_RENDERS - 2]) {
+					matches = false;
+				}
+
+				for (size_t i = 0; i < SNR_RENDERS; i++) {
+					double error = rendered[i] - exact;
+					noise[i] += error * error;
+				}
+			}
+
+			double signal = squared - sum * sum / total;
+
+			printf("%-7s %5u", patch.name, note);
+
+			for (double n : noise) {
+				printf(" %7.1f", snr(signal, n));
+			}
+
+			printf("\n");
+		}
+	}
+
+	printf("# all %s the firmware\n", matches ? "matches" : "DOES NOT match");
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-l length] [-r release] [pitch] [envelope] [snr]\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	double length = 1.0;
+	double release = 1.0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:r:")) != -1) {
+		switch (opt) {
+			case 'l': length = atof(optarg); break;
+			case 'r': release = atof(optarg); break;
+			default: usage(argv[0]);
+		}
+	}
+
+	bool all = optind == argc;
+	bool pitch = all, envelope = all, noise = all;
+
+	for (int i = optind; i < argc; i++) {
+		if (!strcmp(argv[i], "pitch")) {
+			pitch = true;
+		} else if (!strcmp(argv[i], "envelope")) {
+			envelope = true;
+		} else if (!strcmp(argv[i], "snr")) {
+			noise = true;
+		} else {
+			usage(argv[0]);
+		}
+	}
+
+	Tuning.begin();
+
+	if (pitch) {
+		printPitch();
+	}
+	if (envelope) {
+		printEnvelopes();
+	}
+	if (noise) {
+		printSnr(length, release);
+	}
+
+	return 0;
+}
@@ -0,0 +1,485 @@
+// Auduino sweep, renders every combination of a parameter sweep to WAV
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// Usage:
+//   auduino-sweep [-j threads] [-o directory] sweep.txt
+//
+// The spec has one parameter per line, a list of values or an inclusive
+// start:stop:step range, # starts a comment:
+//
+//   grain1   = 0:127:8    # CC16 grain 1 pitch
+//   grain2   = 40 64 96   # CC17 grain 2 pitch
+//   decay1   = 20         # grain 1 decay, 7bit
+//   decay2   = 10         # grain 2 decay, 7bit
+//   note     = 48 60 72   # sync note
+//   velocity = 64 127
+//   length   = 1.0        # seconds held, one value
+//   release  = 0.5        # seconds after note off, one value
+//
+// Each render is one voice of the firmware engine (voice.h, Tuning) at
+// full quality, exactly as the audio interrupt runs it, written as 8bit
+// unsigned at the PWM rate F_CPU / 510. Renders are spread over the
+// threads with work stealing, each thread reuses one output buffer, so
+// a render allocates nothing but its file descriptor.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "voice.h"
+#include "tuning.h"
+
+#define SWEEP_RATE ((F_CPU + 255) / 510)
+
+enum Axis {
+	AXIS_GRAIN1,
+	AXIS_GRAIN2,
+	AXIS_DECAY1,
+	AXIS_DECAY2,
+	AXIS_NOTE,
+	AXIS_VELOCITY,
+	AXES,
+};
+
+static const char *const axisNames[AXES] = {
+	"grain1", "grain2", "decay1", "decay2", "note", "velocity",
+};
+
+// Defaults as in auduino.cpp's defaultPatch, middle C at full velocity
+static const uint8_t axisDefaults[AXES] = { 0, 0, 0, 0, 60, 127 };
+
+static const int8_t syncTranspose[2] = { -24, -17 };
+static const uint8_t envDecay = 1;
+static const uint8_t envDivider = 4;
+
+struct Sweep {
+	std::vector<uint8_t> values[AXES];
+	double length = 1.0;
+	double release = 0.5;
+
+	size_t count() const {
+		size_t n = 1;
+
+		for (auto &axis : values) {
+			n *= axis.size();
+		}
+
+		return n;
+	}
+
+	// Mixed radix, velocity varies fastest
+	void combination(size_t index, uint8_t (&out)[AXES]) const {
+		for (int axis = AXES - 1; axis >= 0; axis--) {
+			out[axis] = values[axis][index % values[axis].size()];
+			index /= values[axis].size();
+		}
+	}
+};
+
+static void fail(const char *path, unsigned line, const char *message) {
+	fprintf(stderr, "%s:%u: %s\n", path, line, message);
+	exit(1);
+}
+
+static void parseValues(const char *path, unsigned line, char *text,
+		std::vector<uint8_t> &values) {
+	values.clear();
+
+	for (char *word = strtok(text, " \t\r\n"); word; word = strtok(nullptr, " \t\r\n")) {
+		int start, stop, step = 1;
+		int fields = sscanf(word, "%d:%d:%d", &start, &stop, &step);
+
+		if (fields == 1) {
+			stop = start;
+		} else if (fields < 2 || step < 1) {
+			fail(path, line, "expected a value or start:stop[:step]");
+		}
+
+		if (start < 0 || stop > 127 || start > stop) {
+			fail(path, line, "values are 0 to 127");
+		}
+
+		for (int value = start; value <= stop; value += step) {
+			values.push_back(value);
+		}
+	}
+
+	if (values.empty()) {
+		fail(path, line, "no values");
+	}
+}
+
+static void parse(const char *path, Sweep &sweep) {
+	FILE *file = fopen(path, "r");
+
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	for (int axis = 0; axis < AXES; axis++) {
+		sweep.values[axis].assign(1, axisDefaults[axis]);
+	}
+
+	char buffer[1024];
+	unsigned line = 0;
+
+	while (fgets(buffer, sizeof(buffer), file)) {
+		line++;
+
+		if (char *comment = strchr(buffer, '#')) {
+			*comment = 0;
+		}
+
+		char *equals = strchr(buffer, '=');
+		char name[32];
+
+		if (sscanf(buffer, " %31[a-z0-9] ", name) != 1) {
+			continue;
+		}
+		if (!equals) {
+			fail(path, line, "expected name = values");
+		}
+
+		char *text = equals + 1;
+
+		if (!strcmp(name, "length")) {
+			sweep.length = atof(text);
+			continue;
+		}
+		if (!strcmp(name, "release")) {
+			sweep.release = atof(text);
+			continue;
+		}
+
+		int axis = 0;
+
+		while (axis < AXES && strcmp(name, axisNames[axis])) {
+			axis++;
+		}
+
+		if (axis == AXES) {
+			fail(path, line, "unknown parameter");
+		}
+
+		parseValues(path, line, text, sweep.values[axis]);
+	}
+
+	fclose(file);
+
+	for (uint8_t note : sweep.values[AXIS_NOTE]) {
+		for (int8_t transpose : syncTranspose) {
+			if (note + transpose < 0) {
+				fail(path, 0, "note too low for the sync transpose");
+			}
+		}
+	}
+}
+
+// 8bit mono PCM, sizes patched in at close()
+class WavWriter {
+	static const size_t headerSize = 44;
+
+	int fd = -1;
+	uint32_t dataSize;
+	size_t used;
+	uint8_t buffer[4096];
+
+	bool flush() {
+		size_t done = 0;
+
+		while (done < used) {
+			ssize_t n = ::write(fd, buffer + done, used - done);
+
+			if (n < 0 && errno != EINTR) {
+				return false;
+			}
+			if (n > 0) {
+				done += n;
+			}
+		}
+
+		used = 0;
+		return true;
+	}
+
+	static void put32(uint8_t *p, uint32_t value) {
+		p[0] = value;
+		p[1] = value >> 8;
+		p[2] = value >> 16;
+		p[3] = value >> 24;
+	}
+
+	static void put16(uint8_t *p, uint16_t value) {
+		p[0] = value;
+		p[1] = value >> 8;
+	}
+
+public:
+	bool open(const char *path, uint32_t rate) {
+		fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+		if (fd < 0) {
+			return false;
+		}
+
+		uint8_t *h = buffer;
+		memcpy(h, "RIFF\0\0\0\0WAVEfmt ", 16);
+		put32(h + 16, 16);
+		put16(h + 20, 1);
+		put16(h + 22, 1);
+		put32(h + 24, rate);
+		put32(h + 28, rate);
+		put16(h + 32, 1);
+		put16(h + 34, 8);
+		memcpy(h + 36, "data\0\0\0\0", 8);
+
+		used = headerSize;
+		dataSize = 0;
+		return true;
+	}
+
+	bool write(uint8_t sample) {
+		buffer[used++] = sample;
+		dataSize++;
+
+		return used < sizeof(buffer) || flush();
+	}
+
+	bool close() {
+		uint8_t size[4];
+		bool ok = flush();
+
+		put32(size, headerSize - 8 + dataSize);
+		ok = ok && pwrite(fd, size, 4, 4) == 4;
+		put32(size, dataSize);
+		ok = ok && pwrite(fd, size, 4, 40) == 4;
+
+		return ::close(fd) == 0 && ok;
+	}
+};
+
+// As the audio interrupt with one voice: note on at the first sample,
+// gate closed after length, single voice mix shift is 0
+static bool render(const Sweep &sweep, const uint8_t (&params)[AXES],
+		WavWriter &wav) {
+	Patch patch = {
+		{ Tuning.interpolate(params[AXIS_GRAIN1] << 7),
+		  Tuning.interpolate(params[AXIS_GRAIN2] << 7) },
+		{ params[AXIS_DECAY1], params[AXIS_DECAY2] },
+		{ syncTranspose[0], syncTranspose[1] },
+		envDecay,
+		envDivider,
+	};
+
+	Voice voice;
+	memset(&voice, 0, sizeof(voice));
+	voice.applyPatch(patch);
+
+	uint8_t note = params[AXIS_NOTE];
+	voice.note.gate = Note::OPEN;
+	voice.env.amp = params[AXIS_VELOCITY] << 8;
+	voice.env.decay = patch.envDecay;
+	voice.env.divider = patch.envDivider;
+	voice.sync[0].setInc(Tuning.inc(note, patch.syncTranspose[0]));
+	voice.sync[1].setInc(Tuning.inc(note, patch.syncTranspose[1]));
+
+	uint32_t held = sweep.length * SWEEP_RATE;
+	uint32_t total = held + static_cast<uint32_t>(sweep.release * SWEEP_RATE);
+
+	for (uint32_t i = 0; i < total; i++) {
+		if (i == held) {
+			voice.note.gate = Note::CLOSED;
+		}
+
+		int16_t output = voice.render(QUALITY_FULL);
+
+		if (!wav.write(static_cast<uint8_t>(output >> 8) + 128)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Each worker owns a range of render indices and takes from its front.
+// An idle worker steals the upper half of the largest remaining range.
+class WorkPool {
+	struct Range {
+		std::mutex lock;
+		// written under lock, read without by thieves choosing a victim
+		std::atomic<size_t> next;
+		std::atomic<size_t> end;
+	};
+
+	std::vector<Range> ranges;
+
+	bool take(size_t worker, size_t &index) {
+		Range &own = ranges[worker];
+		std::lock_guard<std::mutex> guard(own.lock);
+
+		if (own.next == own.end) {
+			return false;
+		}
+
+		index = own.next++;
+		return true;
+	}
+
+	bool steal(size_t worker) {
+		size_t victim = worker;
+		size_t most = 1;
+
+		for (size_t i = 0; i < ranges.size(); i++) {
+			// rechecked under the lock below
+			size_t left = ranges[i].end - ranges[i].next;
+
+			if (i != worker && left > most) {
+				victim = i;
+				most = left;
+			}
+		}
+
+		if (victim == worker) {
+			return false;
+		}
+
+		size_t next, end;
+		{
+			Range &from = ranges[victim];
+			std::lock_guard<std::mutex> guard(from.lock);
+
+			if (from.end - from.next < 2) {
+				return true;
+			}
+
+			end = from.end;
+			next = from.next + (from.end - from.next) / 2;
+			from.end = next;
+		}
+
+		Range &own = ranges[worker];
+		std::lock_guard<std::mutex> guard(own.lock);
+		own.next = next;
+		own.end = end;
+		return true;
+	}
+
+public:
+	explicit WorkPool(size_t workers) : ranges(workers) {}
+
+	template <typename Job>
+	void run(size_t count, Job job) {
+		size_t workers = ranges.size();
+
+		for (size_t i = 0; i < workers; i++) {
+			ranges[i].next = count * i / workers;
+			ranges[i].end = count * (i + 1) / workers;
+		}
+
+		std::vector<std::thread> threads;
+
+		for (size_t i = 0; i < workers; i++) {
+			threads.emplace_back([this, i, &job] () {
+				size_t index;
+
+				for (;;) {
+					if (take(i, index)) {
+						job(i, index);
+					} else if (!steal(i)) {
+						break;
+					}
+				}
+			});
+		}
+
+		for (auto &thread : threads) {
+			thread.join();
+		}
+	}
+};
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-j threads] [-o directory] sweep.txt\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	size_t threads = std::thread::hardware_concurrency();
+	const char *directory = ".";
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:o:")) != -1) {
+		switch (opt) {
+			case 'j': threads = atoi(optarg); break;
+			case 'o': directory = optarg; break;
+			default: usage(argv[0]);
+		}
+	}
+
+	if (argc - optind != 1) {
+		usage(argv[0]);
+	}
+
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	Sweep sweep;
+	parse(argv[optind], sweep);
+	Tuning.begin();
+
+	size_t count = sweep.count();
+	std::vector<WavWriter> writers(threads);
+	std::atomic<size_t> failed(0);
+
+	struct timespec start, stop;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	WorkPool(threads).run(count, [&] (size_t worker, size_t index) {
+		uint8_t params[AXES];
+		char path[4096];
+
+		sweep.combination(index, params);
+		snprintf(path, sizeof(path),
+			"%s/g1-%03u_g2-%03u_d1-%03u_d2-%03u_n%03u_v%03u.wav", directory,
+			params[AXIS_GRAIN1], params[AXIS_GRAIN2], params[AXIS_DECAY1],
+			params[AXIS_DECAY2], params[AXIS_NOTE], params[AXIS_VELOCITY]);
+
+		WavWriter &wav = writers[worker];
+
+		if (!wav.open(path, SWEEP_RATE)) {
+			perror(path);
+			failed++;
+			return;
+		}
+
+		bool ok = render(sweep, params, wav);
+
+		if (!wav.close() || !ok) {
+			perror(path);
+			failed++;
+		}
+	});
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	double elapsed = stop.tv_sec - start.tv_sec + (stop.tv_nsec - start.tv_nsec) / 1e9;
+	double audio = count * (sweep.length + sweep.release);
+
+	fprintf(stderr, "%zu renders, %.0fs of audio in %.2fs on %zu threads, %.0fx real time\n",
+		count, audio, elapsed, threads, elapsed > 0 ? audio / elapsed : 0.0);
+
+	return failed ? 1 : 0;
+}
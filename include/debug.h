@@ -4,6 +4,7 @@
 //
 // ChangeLog:
 // 19 Oct 2012: Add setup method
+// 17 Oct 2026: Binary trace instead of stdio, see trace.h
 
 #ifndef __DEBUG_H__
 #define __DEBUG_H__ 1
@@ -15,15 +16,16 @@
 #  define DEBUGPIN 0x22
 # endif
 
+#include "trace.h"
+
 # ifdef DEBUG
 extern void setup_debug();
-#  define DEBUG_WRITE(fmt, ...) fprintf(stderr, fmt, ##__VA_ARGS__)
-#  define DEBUG_WRITE_P(fmt, ...) fprintf_P(stderr, fmt, ##__VA_ARGS__)
+extern void poll_debug();
 #  define SETUP_DEBUG() setup_debug()
+#  define DEBUG_POLL() poll_debug()
 # else
-#  define DEBUG_WRITE(...) /* __VA_ARGS__ */
-#  define DEBUG_WRITE_P(...) /* __VA_ARGS__ */
 #  define SETUP_DEBUG() /* setup_debug() */
+#  define DEBUG_POLL() /* poll_debug() */
 # endif
 
 #endif
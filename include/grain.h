@@ -4,6 +4,7 @@
 //    Ilja Everilä <saarni@gmail.com>
 //
 // ChangeLog:
+// 17 Oct 2026: render() for a whole grain step
 
 #ifndef __GRAIN_H__
 #define __GRAIN_H__ 1
@@ -27,6 +28,8 @@ struct Grain {
 
   void reset();
   uint16_t getSample() const;
+  // advance phase, sample, decay
+  uint16_t render();
 };
 
 #include "grain.hpp"
@@ -5,6 +5,7 @@
 //
 // ChangeLog:
 // 18 Oct 2012: Attempt at optimizing 8bit multiplications
+// 17 Oct 2026: render() for a whole grain step
 
 #include <avr/pgmspace.h>
 #include "asm.h"
@@ -70,3 +71,11 @@ inline uint16_t Grain::getSample() const {
   // Multiply by current grain amplitude to get sample
   return mul(value, env.value());
 }
+
+inline uint16_t Grain::render() {
+  ++phase;
+  uint16_t sample = getSample();
+  // Make the grain amplitude decay by a factor every sample (exponential decay)
+  env.tick();
+  return sample;
+}
@@ -0,0 +1,22 @@
+// Auduino pot mappings, 10bit analogRead() values to phase increments
+//
+// by Peter Knight, Tinker.it http://tinker.it,
+//    Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Split from auduino.cpp
+
+#ifndef __MAPPING_H__
+#define __MAPPING_H__ 1
+
+#include <stdint.h>
+#include "scale.h"
+
+// Smooth logarithmic mapping
+uint16_t mapPhaseInc(uint16_t input);
+// Stepped mapping to the notes of the current scale
+uint16_t mapScale(uint16_t input);
+
+#include "mapping.hpp"
+
+#endif
@@ -0,0 +1,28 @@
+// Auduino pot mappings, 10bit analogRead() values to phase increments
+//
+// by Peter Knight, Tinker.it http://tinker.it,
+//    Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Split from auduino.cpp
+
+#include <avr/pgmspace.h>
+
+// Smooth logarithmic mapping
+//
+static const uint16_t antilogTable[64] PROGMEM = {
+  64830,64132,63441,62757,62081,61413,60751,60097,59449,58809,58176,57549,56929,56316,55709,55109,
+  54515,53928,53347,52773,52204,51642,51085,50535,49991,49452,48920,48393,47871,47356,46846,46341,
+  45842,45348,44859,44376,43898,43425,42958,42495,42037,41584,41136,40693,40255,39821,39392,38968,
+  38548,38133,37722,37316,36914,36516,36123,35734,35349,34968,34591,34219,33850,33486,33125,32768
+};
+
+inline uint16_t mapPhaseInc(uint16_t input) {
+  return (pgm_read_word(&antilogTable[input & 0x3f])) >> (input >> 6);
+}
+
+// Stepped mapping to the notes of the current scale
+//
+inline uint16_t mapScale(uint16_t input) {
+  return Scale.inc((1023-input) << 4);
+}
@@ -4,11 +4,28 @@
 //
 // ChangeLog:
 // 12 Oct 2012: System Common and Real time made optional
+// 17 Oct 2026: Channel mask for multi-timbral use
+// 17 Oct 2026: Filter channels at status byte, skip foreign data bytes
+// 17 Oct 2026: Configurable baud rate
+// 17 Oct 2026: Soft THRU
+// 17 Oct 2026: 14bit controller pairs, RPN and NRPN
+// 17 Oct 2026: Message timestamps
+// 17 Oct 2026: Streaming SysEx receive, transmit path split from THRU
+// 17 Oct 2026: Uart driver replaces HardwareSerial
+// 17 Oct 2026: canSend() for several bytes
+// 17 Oct 2026: transmitPending()
+// 17 Oct 2026: Stamps taken in the receive interrupt
+// 17 Oct 2026: THRU keeps our own SysEx back in ThruForeign mode
+// 17 Oct 2026: Own messages only between forwarded ones
+// 17 Oct 2026: systemExclusiveAbort
+// 17 Oct 2026: Baud rate tolerance to the datasheet limit
 
 #ifndef __MIDI_H__
 #define __MIDI_H__
 
+#include <stddef.h>
 #include <stdint.h>
+#include "uart.h"
 
 #ifndef MIDI_SYSTEM_COMMON
 # define MIDI_SYSTEM_COMMON 1
@@ -22,21 +39,128 @@
 # define MIDI_CHANNEL_MODE 1
 #endif
 
+// Parse received bytes in serialEventRun(), otherwise read MidiSerial
+// and call Midi.eventHandler() yourself
 #ifndef MIDI_HOOK_SERIAL_EVENT
 # define MIDI_HOOK_SERIAL_EVENT 1
 #endif
 
+// 0, or 1 - 3 on the ATmega1280
+#ifndef MIDI_USART
+# define MIDI_USART 0
+#endif
+
+// Bytes waiting for serialEventRun(), power of two
+#ifndef MIDI_RX_BUFFER_SIZE
+# define MIDI_RX_BUFFER_SIZE 32
+#endif
+
+// 31250 for DIN MIDI, 38400 for ttymidi, 250000 - 1000000 for
+// USB-serial bridges. Not every rate is reachable from every F_CPU,
+// midi.cpp refuses to build if the error exceeds MIDI_BAUD_TOLERANCE;
+// 115200 is 2.1% off at 16MHz.
+#ifndef MIDI_BAUD_RATE
+# define MIDI_BAUD_RATE 31250
+#endif
+
+// Output through a small ring buffer, needed by THRU and SysEx dumps
+#ifndef MIDI_TRANSMIT
+# define MIDI_TRANSMIT 1
+#endif
+
+// Forwards from eventHandler() rather than the receive interrupt, so
+// forwarded and own messages share one transmit path in loop() and
+// cannot interleave. Forwarding is late by the time loop() takes.
+#ifndef MIDI_THRU
+# define MIDI_THRU MIDI_TRANSMIT
+#endif
+
+#if MIDI_THRU && !MIDI_TRANSMIT
+# error "MIDI_THRU needs MIDI_TRANSMIT"
+#endif
+
+// Stamp received bytes with MidiSerial.clock in the receive interrupt,
+// messages carry the stamp of their first byte
+#ifndef MIDI_TIMESTAMP
+# define MIDI_TIMESTAMP 1
+#endif
+
+// Controllers 0 - 31 combined with their LSBs 32 - 63, RPN and NRPN
+#ifndef MIDI_HIGH_RESOLUTION
+# define MIDI_HIGH_RESOLUTION 1
+#endif
+
+// Allowed baud rate error in per mille, 1.5% is the datasheet's
+// recommended maximum for 8N1 in double speed mode
+#ifndef MIDI_BAUD_TOLERANCE
+# define MIDI_BAUD_TOLERANCE 15
+#endif
+
 class _Midi {
-	static const unsigned int baudRate = 38400;
 	static const size_t dataBufferSize = 3;
 
-	uint8_t channel;
+	// bit n set: listen to channel n + 1
+	uint16_t channels;
+	// status of message being received, 0 while skipping data bytes
 	uint8_t currentMessage;
+	uint8_t messageLength;
 	uint8_t bytesToRead;
 	uint8_t dataBuffer[dataBufferSize];
 	size_t dataBufferPosition;
 
-	void messageHandler(uint8_t status);
+#if MIDI_TIMESTAMP
+	uint16_t messageTime;
+	// running status, next data byte starts a new message
+	bool stampNext;
+#endif
+
+#if MIDI_TRANSMIT
+	// power of two
+	static const uint8_t txBufferSize = 16;
+
+	uint8_t txBuffer[txBufferSize];
+	uint8_t txHead;
+	uint8_t txTail;
+#endif
+
+#if MIDI_THRU
+	uint8_t thruMode;
+	// forward data bytes of current message
+	bool thruData;
+	// ThruForeign holds F0 back until the manufacturer ID tells whose
+	bool thruSysExPending;
+	uint8_t sysExId;
+	// data bytes to the end of the forwarded message, 0 between
+	// messages, 0xFF inside SysEx
+	uint8_t thruPending;
+	// last forwarded Channel status and its data bytes, 0 once
+	// cancelled
+	uint8_t thruStatus;
+	uint8_t thruLength;
+	// own message sent since, repeat thruStatus before running status
+	bool thruRestate;
+
+	void forwardStatus(uint8_t status);
+	void forwardData(uint8_t data);
+#endif
+
+#if MIDI_HIGH_RESOLUTION
+	// controller 0 - 31 awaiting its LSB, 0xFF for none
+	uint8_t pairController;
+	uint8_t pairChannel;
+	uint8_t pairMsb;
+	// selected RPN/NRPN, 0x7F7F is the null parameter
+	uint8_t parameterMsb;
+	uint8_t parameterLsb;
+	uint8_t parameterChannel;
+	bool parameterIsNrpn;
+	uint16_t parameterValue;
+
+	bool highResolutionController(uint8_t channel);
+	void deliverParameter();
+#endif
+
+	void messageHandler(uint8_t status, uint16_t time);
 
 	struct Messages {
 		enum ChannelVoice {
@@ -93,10 +217,16 @@ public:
 		uint8_t channel;
 		// enough for 3 byte SysEx manufacturer ID
 		uint8_t data[_Midi::dataBufferSize];
+		// MidiSerial.clock when the first byte was received, 0 without
+		// MIDI_TIMESTAMP
+		uint16_t time;
 	};
 
 	struct Handlers {
 		typedef void (*CallbackPtr)(Message&);
+		// channel, controller or parameter number, 14bit value
+		typedef void (*ControllerCallbackPtr)(uint8_t, uint16_t, uint16_t);
+		typedef void (*DataCallbackPtr)(uint8_t);
 
 		CallbackPtr noteOff               = nullptr;
 		CallbackPtr noteOn                = nullptr;
@@ -105,6 +235,13 @@ public:
 		CallbackPtr programChange         = nullptr;
 		CallbackPtr channelPressure       = nullptr;
 		CallbackPtr pitchWheelChange      = nullptr;
+#if MIDI_HIGH_RESOLUTION
+		// Controllers 0 - 31 are sent here instead of controlChange,
+		// first with the MSB alone and again when the LSB arrives
+		ControllerCallbackPtr controlChange14        = nullptr;
+		ControllerCallbackPtr registeredParameter    = nullptr;
+		ControllerCallbackPtr nonRegisteredParameter = nullptr;
+#endif
 #if MIDI_CHANNEL_MODE
 		CallbackPtr allSoundOff           = nullptr;
 		CallbackPtr resetAllControllers   = nullptr;
@@ -116,7 +253,13 @@ public:
 		CallbackPtr polyModeOn            = nullptr;
 #endif
 #if MIDI_SYSTEM_COMMON
+		// called with the manufacturer ID in data[0], the rest of the
+		// message is streamed to systemExclusiveData
 		CallbackPtr systemExclusive       = nullptr;
+		DataCallbackPtr systemExclusiveData = nullptr;
+		// called with the status byte that cut SysEx short, no
+		// endOfExclusive follows
+		DataCallbackPtr systemExclusiveAbort = nullptr;
 		CallbackPtr timeCodeQuarterFrame  = nullptr;
 		CallbackPtr songPositionPointer   = nullptr;
 		CallbackPtr songSelect            = nullptr;
@@ -137,14 +280,73 @@ public:
 	 * Begin receiving MIDI. Channel 0 means omni mode.
 	 */
 	void begin(int8_t channel = 0);
-	void eventHandler(uint8_t data);
+
+	/**
+	 * Listen to a set of channels, bit n of the mask selects channel
+	 * n + 1. 0xFFFF is omni mode.
+	 */
+	void listen(uint16_t channelMask);
+	/**
+	 * Parse a received byte, time is its receive stamp.
+	 */
+	void eventHandler(uint8_t data, uint16_t time = 0);
+
+#if MIDI_THRU
+	enum Thru {
+		ThruOff,
+		// everything received
+		ThruAll,
+		// only messages on channels we do not listen to
+		ThruForeign,
+	};
+
+	void thru(Thru mode);
+	Thru getThru() const;
+	/**
+	 * SysEx with this manufacturer ID is ours and not passed on in
+	 * ThruForeign mode, 0xFF for none. Universal messages are always
+	 * passed on, they may be for others too.
+	 */
+	void listenSysEx(uint8_t id);
+	/**
+	 * True between forwarded messages, where own messages may go.
+	 */
+	bool thruIdle() const;
+	/**
+	 * Call after an own message, forwarded messages that rely on
+	 * running status get their status byte again.
+	 */
+	void restateRunningStatus();
+#endif
+
+#if MIDI_TRANSMIT
+	/**
+	 * Queue a byte for output. The UART is written directly when idle.
+	 */
+	void send(uint8_t data);
+	/**
+	 * True if send() will not drop the next count bytes.
+	 */
+	bool canSend(uint8_t count = 1) const;
+	/**
+	 * Move queued bytes to the UART, call regularly from loop().
+	 */
+	void transmit();
+	/**
+	 * True while bytes wait for transmit().
+	 */
+	bool transmitPending() const;
+#endif
 
 private:
-	Handlers::CallbackPtr getControlChangeHandler();
+	Handlers::CallbackPtr getControlChangeHandler(uint8_t channel);
 };
 
 // easier to remember and write
 typedef _Midi::Message MidiMessage;
 extern _Midi Midi;
 
+typedef Uart<MIDI_USART, MIDI_RX_BUFFER_SIZE, MIDI_TIMESTAMP> MidiUart;
+extern MidiUart MidiSerial;
+
 #endif
@@ -0,0 +1,54 @@
+// Auduino Scale, quantising pots and controllers to a runtime scale
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version, replaces the fixed pentatonic table
+
+#ifndef __SCALE_H__
+#define __SCALE_H__ 1
+
+#include <stdint.h>
+#include "tuning.h"
+
+// Bit n set: n semitones above the root is in the scale
+enum ScaleMask : uint16_t {
+  SCALE_OFF        = 0x000,
+  SCALE_CHROMATIC  = 0xfff,
+  // 0 2 4 5 7 9 11
+  SCALE_MAJOR      = 0xab5,
+  // 0 2 3 5 7 8 10
+  SCALE_MINOR      = 0x5ad,
+  // 0 2 4 7 9
+  SCALE_PENTATONIC = 0x295,
+};
+
+class _Scale {
+public:
+  /**
+   * Rebuild the note list. SCALE_OFF plays chromatic from pots and
+   * leaves controllers unquantised.
+   */
+  void set(uint16_t mask, uint8_t root);
+  uint16_t getMask() const;
+  uint8_t getRoot() const;
+  /**
+   * Note at a 14bit position, the range is spread evenly over the
+   * notes of the scale. A single table read.
+   */
+  uint8_t note(uint16_t position) const;
+  uint16_t inc(uint16_t position) const;
+
+private:
+  uint16_t mask;
+  uint8_t root;
+  uint8_t count;
+  // scale notes between 0 and 127, ascending
+  uint8_t notes[128];
+};
+
+extern _Scale Scale;
+
+#include "scale.hpp"
+
+#endif
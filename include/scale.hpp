@@ -0,0 +1,23 @@
+// Auduino Scale, quantising pots and controllers to a runtime scale
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+
+inline uint16_t _Scale::getMask() const {
+  return mask;
+}
+
+inline uint8_t _Scale::getRoot() const {
+  return root;
+}
+
+// 8bit x 8bit, count is at most 128
+inline uint8_t _Scale::note(uint16_t position) const {
+  return notes[static_cast<uint8_t>(position >> 6) * count >> 8];
+}
+
+inline uint16_t _Scale::inc(uint16_t position) const {
+  return Tuning.inc(note(position));
+}
@@ -0,0 +1,72 @@
+// Auduino simulator harness, MIDI feed and sample capture for simulavr
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version as the jitter bench
+// 17 Oct 2026: Bridge mode, MIDI from DEBUGPIN and samples to SIM_PORT
+// 17 Oct 2026: Jitter stamps count the way down from TOP too
+//
+// simulavr has no MIDI input, so Timer1 stands in for the USART: once
+// every MIDI byte time its interrupt pushes a byte into the receive
+// ring, and serialEventRun() parses it as usual. Two modes:
+//
+// Jitter bench (make JITTER=1): the bytes are a canned flood at the full
+// MIDI_BAUD_RATE. The audio interrupt writes the cycles between the
+// timer overflow and its PWM write to SIM_PORT right after the write;
+// tools/jitter.py summarises them.
+//
+// Bridge (make BRIDGE=1): each byte time one byte is read from DEBUGPIN,
+// SIM_IDLE for none, so a file prepared by tools/bridge.py plays with
+// wire timing. The audio interrupt writes each sample to SIM_PORT.
+
+#ifndef __SIM_H__
+#define __SIM_H__ 1
+
+# ifndef SIM_PORT
+#  define SIM_PORT 0x21
+# endif
+
+// Undefined System Real Time status, never sent by real devices
+# define SIM_IDLE 0xFD
+
+# if AUDUINO_JITTER_TRACE && AUDUINO_BRIDGE
+#  error "Jitter bench and bridge both use SIM_PORT"
+# endif
+
+# define SIM_FEED (AUDUINO_JITTER_TRACE || AUDUINO_BRIDGE)
+
+# define SIM_WRITE(value) \
+	(*reinterpret_cast<volatile uint8_t *>(SIM_PORT) = (value))
+
+# if SIM_FEED
+extern void setup_sim_feed();
+#  define SETUP_SIM_FEED() setup_sim_feed()
+# else
+#  define SETUP_SIM_FEED() /* setup_sim_feed() */
+# endif
+
+# if AUDUINO_JITTER_TRACE
+// Phase correct PWM counts up to TOP (255) and back down, so a late
+// write would read as a small count. A second read right after the
+// first tells the direction, counting down means 510 - count cycles
+// since the overflow. Logged as 16 bits, low byte first.
+#  define JITTER_TRACE(count) do { \
+	uint8_t _first = (count); \
+	uint8_t _second = (count); \
+	uint16_t _cycles = _second > _first || (_second == _first && _first < 128) \
+		? _first : 510 - _first; \
+	SIM_WRITE(_cycles); \
+	SIM_WRITE(_cycles >> 8); \
+} while (0)
+# else
+#  define JITTER_TRACE(count) /* count */
+# endif
+
+# if AUDUINO_BRIDGE
+#  define BRIDGE_CAPTURE(sample) SIM_WRITE(sample)
+# else
+#  define BRIDGE_CAPTURE(sample) /* sample */
+# endif
+
+#endif
@@ -0,0 +1,145 @@
+// Auduino SysEx dump, bulk save and restore of device state
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+// 17 Oct 2026: SysEx receive left to the sketch, shared with tuning
+// 17 Oct 2026: Status messages
+// 17 Oct 2026: sending()
+// 17 Oct 2026: Own messages only between forwarded ones
+// 17 Oct 2026: receiveAbort()
+//
+// Messages use the non-commercial manufacturer ID:
+//
+//   F0 7D 41 01 F7                          dump request
+//   F0 7D 41 02 vv nn [descriptors] [data] cs F7
+//                                           dump
+//   F0 7D 41 03 [data] F7                   status, sent by the synth
+//
+// vv is the format version, nn the number of regions. Each region is
+// described by 4 bytes: id, size & 0x7F, size >> 7, count. Region data
+// follows packed 7 bytes at a time, each group prefixed with a byte
+// carrying their MSBs (bit n for byte n). cs makes the 7bit sum of the
+// packed data zero. A dump is loaded only if its descriptors match
+// ours exactly. tools/sysex.py reads and writes dumps on the host.
+
+#ifndef __SYSEX_H__
+#define __SYSEX_H__ 1
+
+#include <stdint.h>
+
+#ifndef SYSEX_DUMP
+# define SYSEX_DUMP 1
+#endif
+
+// count items of size bytes, stride bytes apart, starting at data
+struct SysExRegion {
+	uint8_t id;
+	uint8_t count;
+	uint16_t size;
+	uint16_t stride;
+	void *data;
+};
+
+class _SysExDump {
+public:
+	static const uint8_t manufacturerId = 0x7D;
+	static const uint8_t modelId = 0x41;
+	static const uint8_t version = 1;
+
+	enum Command {
+		DumpRequest = 0x01,
+		Dump        = 0x02,
+		Status      = 0x03,
+	};
+
+	typedef void (*LoadedPtr)(bool ok);
+
+	/**
+	 * Called after a dump has been written to the regions, ok is false
+	 * if it was cut short or the checksum failed. Data is written as it
+	 * arrives, so on false every region must be restored.
+	 */
+	LoadedPtr loaded = nullptr;
+
+	/**
+	 * Regions table must be in PROGMEM.
+	 */
+	void begin(const SysExRegion *regions, uint8_t regionCount);
+	/**
+	 * Start sending a dump, transmission happens in poll().
+	 */
+	void send();
+	/**
+	 * Feed the transmitter, call regularly from loop().
+	 */
+	void poll();
+	/**
+	 * True while a dump is being sent.
+	 */
+	bool sending() const;
+	/**
+	 * Send a short status message now, data bytes are masked to 7 bits.
+	 * False if a dump is in progress, a forwarded message is under way
+	 * or there is no room, try again later.
+	 */
+	bool sendStatus(const uint8_t *data, uint8_t length);
+
+	// Feed from the Midi SysEx handlers, messages with other IDs are
+	// ignored
+	void receiveStart(uint8_t id);
+	void receive(uint8_t data);
+	void receiveEnd();
+	// Cut short by a status byte, a partly loaded dump is rejected
+	void receiveAbort();
+
+private:
+	struct Cursor {
+		uint8_t region;
+		uint8_t item;
+		uint16_t offset;
+	};
+
+	enum Phase {
+		Idle,
+		// transmit only, F0 to version
+		Header,
+		Model,
+		Command,
+		Version,
+		RegionCount,
+		Descriptors,
+		Data,
+		End,
+		Ignore,
+	};
+
+	const SysExRegion *regions;
+	uint8_t regionCount;
+
+	Cursor rxCursor;
+	uint8_t rxPhase;
+	uint16_t rxIndex;
+	uint8_t rxGroupMsbs;
+	uint8_t rxGroupPosition;
+	uint8_t rxSum;
+	bool rxRequest;
+
+	Cursor txCursor;
+	uint8_t txPhase;
+	uint16_t txIndex;
+	uint8_t txGroup[7];
+	uint8_t txGroupLength;
+	uint8_t txGroupPosition;
+	uint8_t txSum;
+	uint8_t txThru;
+
+	uint8_t *next(Cursor &cursor);
+	uint8_t descriptorByte(uint16_t index);
+	int16_t nextByte();
+};
+
+extern _SysExDump SysExDump;
+
+#endif
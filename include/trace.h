@@ -0,0 +1,89 @@
+// Auduino trace, binary event log for simulavr
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version, replaces fprintf based DEBUG_WRITE
+// 17 Oct 2026: Timer1 stays free running with the simulator feed
+// 17 Oct 2026: MIDI receive losses
+//
+// TRACE(id, data) stores a 5 byte record, id, Timer1 cycle stamp and a
+// 16bit payload, in a ring. It takes a few cycles and never blocks, so
+// it may be used in interrupts. loop() drains the ring to DEBUGPORT
+// with DEBUG_POLL(), tools/trace.py decodes the stream:
+//
+//   make DEBUG=1 simulate | tools/trace.py
+//
+// Timer1 runs free at F_CPU, the stamp wraps every 4096us. The
+// simulator feed in sim.h shares it through the compare match.
+//
+// tools/trace.py reads the ids and payload descriptions from the enum
+// below, keep one id per line.
+
+#ifndef __TRACE_H__
+#define __TRACE_H__ 1
+
+#include <stdint.h>
+
+# ifndef TRACE_SIZE
+#  define TRACE_SIZE 32
+# endif
+
+enum TraceId : uint8_t {
+	TRACE_LOST,          // records dropped
+	TRACE_MIDI_BEGIN,    // channel, 0 for omni
+	TRACE_NOTE_ON,       // note << 8 | velocity
+	TRACE_NOTE_OFF,      // note
+	TRACE_NOTE_EVENT,    // voice << 8 | velocity, applied by the ISR
+	TRACE_OVERRUN,       // overruns so far
+	TRACE_QUALITY,       // quality level
+	TRACE_AUDIO_STOP,    // sample clock
+	TRACE_AUDIO_RESUME,  // sample clock
+	TRACE_SYSEX_LOADED,  // 1 ok, 0 failed
+	TRACE_TUNING,        // 1 bulk dump, 2 single note change
+	TRACE_MIDI_OVERRUN,  // MIDI bytes lost in the USART so far
+	TRACE_MIDI_DROPPED,  // MIDI bytes lost to a full ring so far
+};
+
+# ifdef DEBUG
+#  include <avr/io.h>
+#  include <util/atomic.h>
+
+struct TraceRecord {
+	uint8_t id;
+	uint16_t time;
+	uint16_t data;
+};
+
+extern TraceRecord traceBuffer[TRACE_SIZE];
+extern volatile uint8_t traceHead;
+extern volatile uint8_t traceTail;
+extern volatile uint8_t traceLost;
+
+static_assert(TRACE_SIZE && !(TRACE_SIZE & (TRACE_SIZE - 1)),
+	"TRACE_SIZE must be a power of two");
+
+// Both loop() and the interrupts record
+inline void trace(uint8_t id, uint16_t data) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t head = traceHead;
+		uint8_t next = (head + 1) & (TRACE_SIZE - 1);
+
+		if (next == traceTail) {
+			traceLost++;
+		} else {
+			TraceRecord &record = traceBuffer[head];
+			record.id = id;
+			record.time = TCNT1;
+			record.data = data;
+			traceHead = next;
+		}
+	}
+}
+
+#  define TRACE(id, data) trace((id), (data))
+# else
+#  define TRACE(id, data) /* trace(id, data) */
+# endif
+
+#endif
@@ -0,0 +1,112 @@
+// Auduino Tuning, MIDI notes to phase increments
+//
+// by Peter Knight, Tinker.it http://tinker.it,
+//    Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Split from auduino.cpp, add RAM table loaded with MIDI
+//              Tuning Standard messages and kept in EEPROM
+// 17 Oct 2026: persisting()
+// 17 Oct 2026: inc() of a transposed note
+// 17 Oct 2026: revert()
+// 17 Oct 2026: Any unfinished change undone at receiveEnd()
+
+#ifndef __TUNING_H__
+#define __TUNING_H__ 1
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// 256 bytes of RAM for microtonal tunings, equal temperament from
+// flash otherwise
+#ifndef TUNING_TABLE
+# define TUNING_TABLE 1
+#endif
+
+// Equal temperament, A4 = 440Hz
+extern const uint16_t midiTable[128] PROGMEM;
+
+class _Tuning {
+public:
+  /**
+   * Load the table from EEPROM, equal temperament if there is none.
+   */
+  void begin();
+  /**
+   * Phase increment of a note, a single table read.
+   */
+  uint16_t inc(uint8_t note) const;
+  /**
+   * Phase increment of a transposed note, clamped to notes 0 - 127.
+   */
+  uint16_t inc(uint8_t note, int8_t transpose) const;
+  /**
+   * Smooth mapping of a 14bit value, note number in the upper 7 bits,
+   * linear interpolation towards the next note in the lower 7.
+   */
+  uint16_t interpolate(uint16_t value) const;
+
+#if TUNING_TABLE
+  uint16_t table[128];
+
+  // Universal SysEx (0x7E, 0x7F), bulk dump and single note tuning
+  // change are acted upon. receiveEnd() also for a message cut short,
+  // an unfinished change is undone
+  void receiveStart(uint8_t id);
+  void receive(uint8_t data);
+  void receiveEnd();
+  /**
+   * Table was written from elsewhere, e.g. a SysEx dump.
+   */
+  void changed();
+  /**
+   * Back to the table in EEPROM, after a corrupt write from elsewhere.
+   */
+  void revert();
+  /**
+   * Persist changes one EEPROM byte at a time, call from loop().
+   */
+  void poll();
+  /**
+   * True until poll() has written every change.
+   */
+  bool persisting() const;
+
+private:
+  enum Phase {
+    Ignore,
+    Device,
+    SubId1,
+    SubId2,
+    Program,
+    Name,
+    BulkData,
+    Checksum,
+    NoteCount,
+    NoteData,
+    End,
+  };
+
+  uint8_t phase;
+  bool bulk;
+  uint8_t checksum;
+  uint8_t index;
+  uint8_t note;
+  uint8_t position;
+  uint8_t data[3];
+  // next EEPROM byte to write, persistDone when idle
+  uint16_t persistIndex;
+
+  static const uint16_t persistDone = 0xffff;
+
+  static uint16_t frequencyToInc(uint8_t semitone, uint16_t fraction);
+  void load();
+  void retune(uint8_t note);
+#endif
+};
+
+extern _Tuning Tuning;
+
+#include "tuning.hpp"
+
+#endif
@@ -0,0 +1,50 @@
+// Auduino Tuning, MIDI notes to phase increments
+//
+// by Peter Knight, Tinker.it http://tinker.it,
+//    Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Split from auduino.cpp
+// 17 Oct 2026: persisting()
+// 17 Oct 2026: inc() of a transposed note
+
+inline uint16_t _Tuning::inc(uint8_t note) const {
+#if TUNING_TABLE
+  return table[note];
+#else
+  return pgm_read_word(&midiTable[note]);
+#endif
+}
+
+inline uint16_t _Tuning::inc(uint8_t note, int8_t transpose) const {
+  int16_t transposed = note + transpose;
+
+  if (transposed < 0) {
+    transposed = 0;
+  } else if (transposed > 127) {
+    transposed = 127;
+  }
+
+  return inc(static_cast<uint8_t>(transposed));
+}
+
+// Linear is at most 0.7 cents off the exponential curve
+inline uint16_t _Tuning::interpolate(uint16_t value) const {
+  uint8_t note = value >> 7;
+  uint8_t fraction = value & 0x7f;
+  uint16_t result = inc(note);
+
+  if (fraction && note < 127) {
+    uint16_t next = inc(note + 1);
+    // tables need not be monotonic
+    result += (static_cast<int32_t>(next) - result) * fraction >> 7;
+  }
+
+  return result;
+}
+
+#if TUNING_TABLE
+inline bool _Tuning::persisting() const {
+  return persistIndex != persistDone;
+}
+#endif
@@ -0,0 +1,157 @@
+// Auduino UART, a small serial driver for MIDI
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version, replaces HardwareSerial
+// 17 Oct 2026: Count overruns and drops
+// 17 Oct 2026: push() for injected bytes
+// 17 Oct 2026: Receive timestamps
+// 17 Oct 2026: No cycle estimate of its own, see auduino.cpp
+//
+// One instance per USART, the number is a template parameter so register
+// access compiles to plain lds/sts. Received bytes wait in a power of
+// two ring indexed with a mask; nothing is virtual. Transmit is left to
+// the caller polling writable(), there is no transmit buffer or
+// interrupt. Declare the receive interrupt next to the instance:
+//
+//   Uart<1> serial;
+//   UART_RX_ISR(1, serial)
+//
+// A Stamped instance also keeps *clock, read in the receive interrupt,
+// for each byte; time() tells it for the byte read() returns next.
+
+#ifndef __UART_H__
+#define __UART_H__ 1
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+template <uint8_t N> struct UartRegisters;
+
+#define UART_REGISTERS(n, ucsra_, ucsrb_, ubrrh_, ubrrl_, udr_) \
+	template <> struct UartRegisters<n> { \
+		static volatile uint8_t &ucsra() { return ucsra_; } \
+		static volatile uint8_t &ucsrb() { return ucsrb_; } \
+		static volatile uint8_t &ubrrh() { return ubrrh_; } \
+		static volatile uint8_t &ubrrl() { return ubrrl_; } \
+		static volatile uint8_t &udr()   { return udr_; } \
+	}
+
+#if defined(UBRR0H)
+UART_REGISTERS(0, UCSR0A, UCSR0B, UBRR0H, UBRR0L, UDR0);
+#elif defined(UBRRH)
+UART_REGISTERS(0, UCSRA, UCSRB, UBRRH, UBRRL, UDR);
+#endif
+#if defined(UBRR1H)
+UART_REGISTERS(1, UCSR1A, UCSR1B, UBRR1H, UBRR1L, UDR1);
+#endif
+#if defined(UBRR2H)
+UART_REGISTERS(2, UCSR2A, UCSR2B, UBRR2H, UBRR2L, UDR2);
+#endif
+#if defined(UBRR3H)
+UART_REGISTERS(3, UCSR3A, UCSR3B, UBRR3H, UBRR3L, UDR3);
+#endif
+
+// Bit positions are the same for every USART of a device
+#if defined(U2X0)
+# define UART_U2X   U2X0
+# define UART_UDRE  UDRE0
+# define UART_RXEN  RXEN0
+# define UART_TXEN  TXEN0
+# define UART_RXCIE RXCIE0
+# define UART_DOR   DOR0
+#else
+# define UART_U2X   U2X
+# define UART_UDRE  UDRE
+# define UART_RXEN  RXEN
+# define UART_TXEN  TXEN
+# define UART_RXCIE RXCIE
+# define UART_DOR   DOR
+#endif
+
+#if defined(USART_RX_vect)
+# define UART0_RX_vect USART_RX_vect
+#elif defined(USART0_RX_vect)
+# define UART0_RX_vect USART0_RX_vect
+#else
+# define UART0_RX_vect USART_RXC_vect
+#endif
+#define UART1_RX_vect USART1_RX_vect
+#define UART2_RX_vect USART2_RX_vect
+#define UART3_RX_vect USART3_RX_vect
+
+// The whole receive interrupt only moves a byte to the ring, see the
+// interrupt scheme in auduino.cpp.
+// Extra level so that n may be a macro
+#define UART_RX_ISR(n, uart) UART_RX_ISR_(n, uart)
+#define UART_RX_ISR_(n, uart) \
+	ISR(UART##n##_RX_vect) { \
+		uart.receive(); \
+	}
+
+template <uint8_t N, uint8_t RxBufferSize = 32, bool Stamped = false>
+class Uart {
+	static_assert(RxBufferSize && !(RxBufferSize & (RxBufferSize - 1)),
+		"RxBufferSize must be a power of two");
+
+	typedef UartRegisters<N> Registers;
+
+	volatile uint8_t rxBuffer[RxBufferSize];
+	volatile uint16_t rxTime[Stamped ? RxBufferSize : 1];
+	volatile uint8_t rxHead;
+	volatile uint8_t rxTail;
+	// wrap around, compare against an earlier reading
+	volatile uint8_t rxOverruns;
+	volatile uint8_t rxDropped;
+
+public:
+	/**
+	 * Time source for receive stamps, e.g. a sample counter. The
+	 * interrupt reads it as is, update it with interrupts disabled.
+	 * Stamped only.
+	 */
+	volatile uint16_t *clock = nullptr;
+
+	/**
+	 * 8N1 in double speed mode, ubrr is the divisor for that.
+	 */
+	void begin(uint16_t ubrr);
+	bool available() const;
+	/**
+	 * Next received byte, check available() first.
+	 */
+	uint8_t read();
+	/**
+	 * *clock when the next byte was received, 0 without a clock or
+	 * Stamped. Check available() first.
+	 */
+	uint16_t time() const;
+	bool writable() const;
+	/**
+	 * Write straight to the data register, check writable() first.
+	 */
+	void write(uint8_t data);
+	/**
+	 * Bytes lost in hardware, the receive interrupt was held off for
+	 * more than two byte times.
+	 */
+	uint8_t overruns() const;
+	/**
+	 * Bytes lost because the ring was full, serialEventRun() fell behind.
+	 */
+	uint8_t dropped() const;
+	/**
+	 * Called from UART_RX_ISR only. Bytes are dropped if the ring is full.
+	 */
+	void receive();
+	/**
+	 * Queue a byte as if received, from an interrupt only.
+	 */
+	void push(uint8_t data);
+};
+
+#include "uart.hpp"
+
+#endif
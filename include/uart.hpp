@@ -0,0 +1,85 @@
+// Auduino UART, a small serial driver for MIDI
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+// 17 Oct 2026: Count overruns and drops
+// 17 Oct 2026: push() for injected bytes
+// 17 Oct 2026: Receive timestamps
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+void Uart<N, RxBufferSize, Stamped>::begin(uint16_t ubrr) {
+	rxHead = rxTail = 0;
+	rxOverruns = rxDropped = 0;
+	// 8N1 is the reset default
+	Registers::ucsra() = _BV(UART_U2X);
+	Registers::ubrrh() = ubrr >> 8;
+	Registers::ubrrl() = ubrr;
+	Registers::ucsrb() = _BV(UART_RXEN) | _BV(UART_TXEN) | _BV(UART_RXCIE);
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline bool Uart<N, RxBufferSize, Stamped>::available() const {
+	return rxHead != rxTail;
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline uint8_t Uart<N, RxBufferSize, Stamped>::read() {
+	uint8_t tail = rxTail;
+	uint8_t data = rxBuffer[tail];
+
+	rxTail = (tail + 1) & (RxBufferSize - 1);
+	return data;
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline uint16_t Uart<N, RxBufferSize, Stamped>::time() const {
+	return Stamped ? rxTime[rxTail] : 0;
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline bool Uart<N, RxBufferSize, Stamped>::writable() const {
+	return Registers::ucsra() & _BV(UART_UDRE);
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline void Uart<N, RxBufferSize, Stamped>::write(uint8_t data) {
+	Registers::udr() = data;
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline uint8_t Uart<N, RxBufferSize, Stamped>::overruns() const {
+	return rxOverruns;
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline uint8_t Uart<N, RxBufferSize, Stamped>::dropped() const {
+	return rxDropped;
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline void Uart<N, RxBufferSize, Stamped>::receive() {
+	// DOR is only valid before UDR is read
+	if (Registers::ucsra() & _BV(UART_DOR)) {
+		rxOverruns++;
+	}
+
+	push(Registers::udr());
+}
+
+template <uint8_t N, uint8_t RxBufferSize, bool Stamped>
+inline void Uart<N, RxBufferSize, Stamped>::push(uint8_t data) {
+	uint8_t head = rxHead;
+	uint8_t next = (head + 1) & (RxBufferSize - 1);
+
+	if (next != rxTail) {
+		rxBuffer[head] = data;
+		if (Stamped) {
+			rxTime[head] = clock ? *clock : 0;
+		}
+		rxHead = next;
+	} else {
+		rxDropped++;
+	}
+}
@@ -0,0 +1,68 @@
+// Auduino Voice, a pair of grains driven by sync oscillators
+//
+// by Peter Knight, Tinker.it http://tinker.it,
+//    Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Split from auduino.cpp, add Patch for multi-timbral parts
+// 17 Oct 2026: Reduced quality levels for CPU overload
+// 17 Oct 2026: Quality levels relative to the sound, skip()
+
+#ifndef __VOICE_H__
+#define __VOICE_H__ 1
+
+#include <stdint.h>
+#include "phase.h"
+#include "grain.h"
+
+struct Note {
+  enum Gate {
+    CLOSED,
+    OPEN,
+  } gate;
+
+  uint8_t number;
+  uint8_t velocity;
+};
+
+// Sound parameters shared by all voices of a part
+struct Patch {
+  uint16_t grainInc[2];
+  uint8_t grainDecay[2];
+  // sync oscillator pitch relative to played note, in semitones
+  int8_t syncTranspose[2];
+  uint8_t envDecay;
+  uint8_t envDivider;
+};
+
+// Shortcuts taken when samples overrun, each level includes the ones
+// above it. They are relative to the sound, so each level saves time
+// however loud every grain and voice is.
+enum Quality : uint8_t {
+  QUALITY_FULL,
+  // only the louder grain of each voice is advanced and heard
+  QUALITY_LOUDER_GRAIN,
+  // idle voices are left out and only the loudest few rendered, the
+  // rest skip() until they rank again
+  QUALITY_VOICE_LIMIT,
+  QUALITY_LOWEST = QUALITY_VOICE_LIMIT,
+};
+
+struct Voice {
+  Note note;
+  Env env;
+  Phase sync[2];
+  Grain grains[2];
+
+  void applyPatch(const Patch &patch);
+  bool idle() const;
+  int16_t render(uint8_t quality);
+  /**
+   * Keep time without rendering, the voice decays as if heard.
+   */
+  void skip();
+};
+
+#include "voice.hpp"
+
+#endif
@@ -0,0 +1,82 @@
+// Auduino Voice, a pair of grains driven by sync oscillators
+//
+// by Peter Knight, Tinker.it http://tinker.it,
+//    Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Split from auduino.cpp
+// 17 Oct 2026: Reduced quality levels for CPU overload
+// 17 Oct 2026: Quality levels relative to the sound, skip()
+// 17 Oct 2026: Single grain doubled
+
+#include "asm.h"
+
+inline void Voice::applyPatch(const Patch &patch) {
+  grains[0].phase.setInc(patch.grainInc[0]);
+  grains[1].phase.setInc(patch.grainInc[1]);
+  grains[0].env.decay = patch.grainDecay[0];
+  grains[1].env.decay = patch.grainDecay[1];
+}
+
+inline bool Voice::idle() const {
+  return note.gate == Note::CLOSED && !env.value();
+}
+
+inline int16_t Voice::render(uint8_t quality) {
+  ++sync[0];
+  ++sync[1];
+
+  if (sync[0].hasOverflowed()) {
+    // Time to start the next grain
+    grains[0].reset();
+  }
+
+  if (sync[1].hasOverflowed()) {
+    grains[1].reset();
+  }
+
+  uint16_t output = 0;
+
+  if (quality < QUALITY_LOUDER_GRAIN) {
+    output =  grains[0].render();
+    output += grains[1].render();
+  } else if (grains[0].env.value() >= grains[1].env.value()) {
+    // The quieter grain is left frozen until its next reset. Doubled to
+    // keep the level and DC of the pair
+    output = grains[0].render() << 1;
+  } else {
+    output = grains[1].render() << 1;
+  }
+
+  // It's ok to leave the PWM to what ever value it is when gate closes,
+  // since HPF should remove DC voltages.
+  if (note.gate == Note::CLOSED) {
+    env.tick();
+  }
+
+  // Scale and shift output to the available signed range for amplitude calculations
+  int8_t scaled_output = static_cast<uint8_t>(output >> 7) - 128;
+
+  // 2 * 127 * 255  + 2 * 255  = 65280,  well within unsigned 16bit limits
+  // 2 * 127 * -128 + 2 * -128 = -32768, ok
+  // 2 * 127 * 127  + 2 * 127  = 32512,  ok
+  // value = output * (velocity + 1) / (127 + 1)
+  //       = output * (velocity + 1) * 2 / ((127 + 1) * 2)
+  //       = output * (2 * velocity + 2) / 256
+  //       = (2 * velocity * output + 2 * output) / 256
+  //
+  // mul() from grain.h, grain.hpp
+  int16_t scaled_output_x2 = mulsu(scaled_output, 2);
+  scaled_output_x2 += scaled_output_x2 * env.value();
+  return scaled_output_x2;
+}
+
+// Grains stay frozen, the sync oscillators reset them once rendered again
+inline void Voice::skip() {
+  ++sync[0];
+  ++sync[1];
+
+  if (note.gate == Note::CLOSED) {
+    env.tick();
+  }
+}
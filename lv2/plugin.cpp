@@ -0,0 +1,258 @@
+// Auduino LV2 instrument, the firmware on the virtual MCU of host/
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+//
+// src/auduino.cpp and the MIDI sources run unmodified against the stub
+// AVR headers of host/include, exactly as in auduino-host: every CC,
+// NRPN and SysEx dump is received by the same _Midi handlers and played
+// by the same Voice, so patches sound the same here and on the device.
+//
+// MIDI events go onto the virtual wire at their frame time. The engine
+// runs at its own F_CPU / 510 and each output frame takes the PWM value
+// at the middle of the frame, or with oversampling above 1 the average
+// of that many points spread over the frame, a box filter against the
+// aliasing of the sample rate conversion.
+//
+// The firmware keeps its state in globals, so there can be one instance
+// per process. It is never reset once running, like a device left
+// powered on; activate() sends All Sound Off on every channel instead.
+// run() neither allocates nor blocks.
+
+#include <math.h>
+#include <string.h>
+#include <lv2/core/lv2.h>
+#include <lv2/atom/atom.h>
+#include <lv2/atom/util.h>
+#include <lv2/midi/midi.h>
+#include <lv2/urid/urid.h>
+#include "host.h"
+
+#define AUDUINO_URI "http://github.com/everilae/auduino"
+
+// Bytes reach the firmware within a sample of their frame time
+#define AUDUINO_LV2_BAUD 1000000UL
+
+// MIDI bytes waiting for the wire, power of two
+#ifndef AUDUINO_LV2_QUEUE
+# define AUDUINO_LV2_QUEUE 4096
+#endif
+
+// Engine samples kept for conversion, power of two
+#define AUDUINO_LV2_SAMPLES 4096
+
+#define AUDUINO_LV2_MAX_OVERSAMPLING 16
+
+// Virtual cost of one pass of loop() that did not sleep, as main.cpp
+#define AUDUINO_LV2_LOOP_CYCLES 256
+
+extern void setup();
+extern void loop();
+extern void serialEventRun() __attribute__((weak));
+
+enum Port {
+	PORT_MIDI_IN,
+	PORT_AUDIO_OUT,
+	PORT_OVERSAMPLING,
+};
+
+struct Auduino {
+	const LV2_Atom_Sequence *midiIn;
+	float *audioOut;
+	const float *oversampling;
+
+	LV2_URID midiEvent;
+	double cyclesPerFrame;
+	// frames per conversion chunk, the sample ring covers two
+	uint32_t chunkFrames;
+	// since instantiate, virtual time started with it
+	uint64_t frames;
+
+	uint64_t due[AUDUINO_LV2_QUEUE];
+	uint8_t data[AUDUINO_LV2_QUEUE];
+	uint32_t head;
+	uint32_t tail;
+
+	// PWM value by engine sample number
+	uint8_t samples[AUDUINO_LV2_SAMPLES];
+};
+
+// Host callbacks take no context
+static Auduino *instance;
+
+// Once per byte slot
+static int wire() {
+	Auduino &self = *instance;
+
+	if (self.head != self.tail && self.due[self.tail & (AUDUINO_LV2_QUEUE - 1)] <= Host.cycles) {
+		return self.data[self.tail++ & (AUDUINO_LV2_QUEUE - 1)];
+	}
+
+	return HOST_IDLE;
+}
+
+// Once per sample period, at a multiple of HOST_SAMPLE_CYCLES
+static void capture(uint8_t value) {
+	instance->samples[Host.cycles / HOST_SAMPLE_CYCLES & (AUDUINO_LV2_SAMPLES - 1)] = value;
+}
+
+// An event that does not fit is dropped whole, never cut short
+static void send(Auduino &self, uint64_t due, const uint8_t *bytes, uint32_t size) {
+	if (AUDUINO_LV2_QUEUE - (self.head - self.tail) < size) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < size; i++) {
+		self.due[self.head & (AUDUINO_LV2_QUEUE - 1)] = due;
+		self.data[self.head & (AUDUINO_LV2_QUEUE - 1)] = bytes[i];
+		self.head++;
+	}
+}
+
+// As the driver loop of main.cpp, sleeps end at until
+static void advance(uint64_t until) {
+	Host.end = until;
+
+	while (!Host.done()) {
+		loop();
+
+		if (serialEventRun) {
+			serialEventRun();
+		}
+
+		Host.run(Host.cycles + AUDUINO_LV2_LOOP_CYCLES);
+	}
+}
+
+static LV2_Handle instantiate(const LV2_Descriptor *, double rate, const char *,
+		const LV2_Feature *const *features) {
+	const LV2_URID_Map *map = nullptr;
+
+	for (int i = 0; features[i]; i++) {
+		if (!strcmp(features[i]->URI, LV2_URID__map)) {
+			map = static_cast<const LV2_URID_Map *>(features[i]->data);
+		}
+	}
+
+	if (!map || instance) {
+		return nullptr;
+	}
+
+	Auduino *self = new Auduino();
+
+	self->midiEvent = map->map(map->handle, LV2_MIDI__MidiEvent);
+	self->cyclesPerFrame = F_CPU / rate;
+	self->chunkFrames = AUDUINO_LV2_SAMPLES / 2 * HOST_SAMPLE_CYCLES / self->cyclesPerFrame;
+
+	if (self->chunkFrames < 1) {
+		self->chunkFrames = 1;
+	}
+
+	memset(self->samples, 128, sizeof(self->samples));
+	instance = self;
+
+	Host.reset(AUDUINO_LV2_BAUD);
+	Host.input = wire;
+	Host.output = capture;
+
+	// As runtime.cpp
+	setup();
+	Host.enableInterrupts();
+
+	return self;
+}
+
+static void connectPort(LV2_Handle handle, uint32_t port, void *data) {
+	Auduino &self = *static_cast<Auduino *>(handle);
+
+	switch (port) {
+		case PORT_MIDI_IN: self.midiIn = static_cast<const LV2_Atom_Sequence *>(data); break;
+		case PORT_AUDIO_OUT: self.audioOut = static_cast<float *>(data); break;
+		case PORT_OVERSAMPLING: self.oversampling = static_cast<const float *>(data); break;
+	}
+}
+
+static void activate(LV2_Handle handle) {
+	Auduino &self = *static_cast<Auduino *>(handle);
+	uint64_t now = self.frames * self.cyclesPerFrame;
+
+	self.tail = self.head;
+
+	for (uint8_t channel = 0; channel < 16; channel++) {
+		const uint8_t allSoundOff[] = { static_cast<uint8_t>(0xB0 | channel), 120, 0 };
+		send(self, now, allSoundOff, sizeof(allSoundOff));
+	}
+}
+
+static void run(LV2_Handle handle, uint32_t count) {
+	Auduino &self = *static_cast<Auduino *>(handle);
+
+	LV2_ATOM_SEQUENCE_FOREACH(self.midiIn, event) {
+		if (event->body.type == self.midiEvent) {
+			uint64_t due = (self.frames + event->time.frames) * self.cyclesPerFrame;
+			send(self, due, static_cast<const uint8_t *>(LV2_ATOM_BODY_CONST(&event->body)),
+				event->body.size);
+		}
+	}
+
+	int points = self.oversampling ? lrintf(*self.oversampling) : 1;
+
+	if (points < 1) {
+		points = 1;
+	} else if (points > AUDUINO_LV2_MAX_OVERSAMPLING) {
+		points = AUDUINO_LV2_MAX_OVERSAMPLING;
+	}
+
+	double step = self.cyclesPerFrame / points;
+	float *out = self.audioOut;
+
+	while (count) {
+		uint32_t frames = count < self.chunkFrames ? count : self.chunkFrames;
+
+		advance(ceil((self.frames + frames) * self.cyclesPerFrame));
+
+		for (uint32_t i = 0; i < frames; i++) {
+			double time = (self.frames + i) * self.cyclesPerFrame + step / 2;
+			uint32_t sum = 0;
+
+			for (int point = 0; point < points; point++) {
+				uint64_t sample = static_cast<uint64_t>(time + point * step) / HOST_SAMPLE_CYCLES;
+				sum += self.samples[sample & (AUDUINO_LV2_SAMPLES - 1)];
+			}
+
+			*out++ = (static_cast<float>(sum) / points - 128) / 128;
+		}
+
+		self.frames += frames;
+		count -= frames;
+	}
+}
+
+static void deactivate(LV2_Handle) {
+}
+
+static void cleanup(LV2_Handle handle) {
+	delete static_cast<Auduino *>(handle);
+	instance = nullptr;
+}
+
+static const void *extensionData(const char *) {
+	return nullptr;
+}
+
+static const LV2_Descriptor descriptor = {
+	AUDUINO_URI,
+	instantiate,
+	connectPort,
+	activate,
+	run,
+	deactivate,
+	cleanup,
+	extensionData,
+};
+
+LV2_SYMBOL_EXPORT const LV2_Descriptor *lv2_descriptor(uint32_t index) {
+	return index == 0 ? &descriptor : nullptr;
+}
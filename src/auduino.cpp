@@ -19,33 +19,166 @@
 // 7  Apr 2009: Fixed interrupt vector for ATmega328 boards
 // 8  Apr 2009: Added support for ATmega1280 boards (Arduino Mega)
 // 12 Oct 2012: Made source more C++11 friendly, added initial Midi
+// 17 Oct 2026: Multi-timbral parts, one per MIDI channel
+// 17 Oct 2026: Active sensing watchdog, channel mode messages
+// 17 Oct 2026: Parameter map with 14bit controllers and NRPN
+// 17 Oct 2026: Sample accurate note events
+// 17 Oct 2026: SysEx dump and restore of patches and maps
+// 17 Oct 2026: MIDI Tuning Standard, notes from a RAM tuning table
+// 17 Oct 2026: Runtime scales replace the fixed MIDI and pentatonic maps
+// 17 Oct 2026: Pins set up through registers, builds without the core
+// 17 Oct 2026: Audio interrupt writes first and lets MIDI in while rendering
+// 17 Oct 2026: Jitter bench trace
+// 17 Oct 2026: Overrun detection, quality steps down under overload
+// 17 Oct 2026: Sleep between interrupts, stop audio when silent
+// 17 Oct 2026: Trace events
+// 17 Oct 2026: Simulator bridge capture
+// 17 Oct 2026: Idle sleep while the note event queue is full
+// 17 Oct 2026: Pot mappings split to mapping.h
+// 17 Oct 2026: No sleep with output pending while the audio is stopped
+// 17 Oct 2026: Interrupt cycle bounds marked as estimates
+// 17 Oct 2026: Transposed sync notes clamped to the tuning table
+// 17 Oct 2026: Every region restored after a corrupt SysEx dump
+// 17 Oct 2026: MIDI stamped in the receive interrupt, latency from wire time
+// 17 Oct 2026: Own SysEx kept from THRU
+// 17 Oct 2026: Overload drops the quieter grain, then caps rendered voices
+// 17 Oct 2026: SysEx cut short by a status byte restores the dump
+// 17 Oct 2026: MIDI receive losses traced, cycle budgets not asserted
+// 17 Oct 2026: ATmega8 audio keeps the other timers' interrupts
+// 17 Oct 2026: All Notes Off releases, active sensing timeout from F_CPU
 
-#include <Arduino.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <avr/power.h>
+#include <util/atomic.h>
+#include <string.h>
 #include "phase.h"
 #include "grain.h"
+#include "voice.h"
 #include "midi.h"
+#include "sysex.h"
+#include "tuning.h"
+#include "scale.h"
+#include "mapping.h"
 #include "asm.h"
 #include "debug.h"
+#include "sim.h"
 
-struct Note {
-  enum Gate {
-    CLOSED,
-    OPEN,
-  } gate;
+// Multi-timbral setup: part n listens to MIDI channel n + 1 and plays
+// its own subset of voices with its own patch. A single part listens
+// to all channels.
+#ifndef AUDUINO_PARTS
+# define AUDUINO_PARTS 1
+#endif
+
+#ifndef AUDUINO_VOICES_PER_PART
+# define AUDUINO_VOICES_PER_PART 1
+#endif
+
+// Sleep between interrupts, and stop the audio timer after
+// AUDUINO_SILENCE samples without sound
+#ifndef AUDUINO_SLEEP
+# define AUDUINO_SLEEP 1
+#endif
+
+#ifndef AUDUINO_SILENCE
+# define AUDUINO_SILENCE 16384
+#endif
+
+#define VOICES (AUDUINO_PARTS * AUDUINO_VOICES_PER_PART)
+
+// Voices rendered at QUALITY_VOICE_LIMIT, the loudest ones
+#ifndef AUDUINO_OVERLOAD_VOICES
+# define AUDUINO_OVERLOAD_VOICES ((VOICES + 1) / 2)
+#endif
+
+static_assert(AUDUINO_PARTS >= 1 && AUDUINO_PARTS <= 16, "1 to 16 parts");
+static_assert(VOICES <= 4, "more voices will not fit the sample budget");
+
+// Voice outputs are scaled down before mixing to keep the sum in 16bit
+#define VOICE_MIX_SHIFT (VOICES > 2 ? 2 : VOICES - 1)
+
+struct Part {
+  Patch patch;
+  uint8_t firstVoice;
+  uint8_t voiceCount;
+  uint8_t nextVoice;
+};
+
+static Voice voices[VOICES];
+static Part parts[AUDUINO_PARTS];
+// part index for each MIDI channel, NO_PART if not listened to
+#define NO_PART 0xff
+static uint8_t channelParts[16];
+
+// Samples since power on, wraps every ~2s
+static volatile uint16_t sampleClock;
+
+// Once active sensing has been seen, silence if it stops for 300ms of
+// F_CPU / 510 samples
+#define ACTIVE_SENSING_TIMEOUT (F_CPU / 510 * 300 / 1000)
+
+static uint16_t activeSensingTime;
+static bool activeSensing;
+
+// Notes start and stop this many samples after the first byte of their
+// MIDI message was received, the ISR applies them on the exact sample.
+// The rest of a Note On takes two byte times on the wire, a sample is
+// 510 cycles, then loop() has NOTE_LOOP_LATENCY samples to parse it and
+// queue the event. An event queued later plays at once, late by the
+// difference.
+#ifndef NOTE_LOOP_LATENCY
+# define NOTE_LOOP_LATENCY 32
+#endif
+
+#define NOTE_LATENCY (2 * (MIDI_BYTE_CYCLES / 510 + 1) + NOTE_LOOP_LATENCY)
 
-  uint8_t number;
+// Gate changes for the ISR, velocity 0 closes the gate
+struct NoteEvent {
+  uint16_t time;
+  uint8_t voice;
   uint8_t velocity;
+  uint8_t envDecay;
+  uint8_t envDivider;
+  uint16_t syncInc[2];
 };
 
-static struct Voice {
-  Note note;
-  Env env;
-  Phase sync[2];
-  Grain grains[2];
-} voices[2];
+// Single producer (loop), single consumer (ISR), power of two
+#define NOTE_EVENTS 8
+
+static NoteEvent noteEvents[NOTE_EVENTS];
+// rendered ahead, written on the next overflow
+static uint8_t pwmValue = 128;
+
+// Samples that took longer than a period, counted by the ISR
+static volatile uint16_t audioOverruns;
+static volatile uint8_t quality = QUALITY_FULL;
+// outside the AUDUINO_OVERLOAD_VOICES loudest, set by rankVoices()
+static volatile bool voiceCapped[VOICES];
+
+// Overload is judged once per window (~131ms). A window with overruns
+// lowers quality a step, OVERLOAD_CALM clean windows in a row raise it
+// again.
+#define OVERLOAD_WINDOW 4096
+#define OVERLOAD_CALM   8
+
+static uint16_t overloadWindowStart;
+static uint16_t overrunsSeen;
+static uint8_t calmWindows;
+// quality changed, not yet reported
+static bool overloadReport;
+static volatile uint8_t noteEventHead;
+static volatile uint8_t noteEventTail;
+
+static const Patch defaultPatch = {
+  { 0, 0 },
+  { 0, 0 },
+  { -24, -17 },
+  1,
+  4,
+};
 
 // Map Analogue channels
 #define SYNC_CONTROL         (4)
@@ -64,10 +197,18 @@ static struct Voice {
 //
 #define LED_PIN       13
 #define LED_PORT      PORTB
+#define LED_DDR       DDRB
 #define LED_BIT       5
 #define PWM_PIN       11
+#define PWM_DDR       DDRB
+#define PWM_BIT       3
 #define PWM_VALUE     OCR2
+#define PWM_COUNT     TCNT2
 #define PWM_INTERRUPT TIMER2_OVF_vect
+#define PWM_TIMSK     TIMSK
+#define PWM_TOIE      TOIE2
+#define PWM_TIFR      TIFR
+#define PWM_TOV       TOV2
 #elif defined(__AVR_ATmega1280__)
 //
 // On the Arduino Mega
@@ -75,243 +216,859 @@ static struct Voice {
 //
 #define LED_PIN       13
 #define LED_PORT      PORTB
+#define LED_DDR       DDRB
 #define LED_BIT       7
 #define PWM_PIN       3
+#define PWM_DDR       DDRE
+#define PWM_BIT       5
 #define PWM_VALUE     OCR3C
+#define PWM_COUNT     TCNT3L
 #define PWM_INTERRUPT TIMER3_OVF_vect
+#define PWM_TIMSK     TIMSK3
+#define PWM_TOIE      TOIE3
+#define PWM_TIFR      TIFR3
+#define PWM_TOV       TOV3
 #else
 //
 // For modern ATmega168 and ATmega328 boards
 //    Output is on pin 3
 //
 #define PWM_PIN       3
+#define PWM_DDR       DDRD
+#define PWM_BIT       3
 #define PWM_VALUE     OCR2B
+#define PWM_COUNT     TCNT2
 #define LED_PIN       13
 #define LED_PORT      PORTB
+#define LED_DDR       DDRB
 #define LED_BIT       5
 #define PWM_INTERRUPT TIMER2_OVF_vect
+#define PWM_TIMSK     TIMSK2
+#define PWM_TOIE      TOIE2
+#define PWM_TIFR      TIFR2
+#define PWM_TOV       TOV2
 #endif
 
-// Smooth logarithmic mapping
+// Interrupt scheme
 //
-static const uint16_t antilogTable[64] PROGMEM = {
-  64830,64132,63441,62757,62081,61413,60751,60097,59449,58809,58176,57549,56929,56316,55709,55109,
-  54515,53928,53347,52773,52204,51642,51085,50535,49991,49452,48920,48393,47871,47356,46846,46341,
-  45842,45348,44859,44376,43898,43425,42958,42495,42037,41584,41136,40693,40255,39821,39392,38968,
-  38548,38133,37722,37316,36914,36516,36123,35734,35349,34968,34591,34219,33850,33486,33125,32768
-};
+// AVR has no interrupt priorities, whichever interrupt runs holds off
+// the others. The audio interrupt therefore
+//
+//  1. writes the sample rendered on its previous run first, a fixed and
+//     short time after the overflow. The compare register is double
+//     buffered and latched at TOP, half a period later, so interrupt
+//     latency below that does not move the sample in time at all.
+//  2. masks its own overflow interrupt and enables interrupts, so the
+//     UART receive interrupt may preempt rendering.
+//  3. disables interrupts again and unmasks itself at the end.
+//
+// The UART receive interrupt only moves a byte to a ring and runs with
+// interrupts disabled. With the Arduino core, Timer0's millis()
+// interrupt is a third source of latency; the bare metal build has
+// none. ATOMIC_BLOCKs in loop() count as well and must stay short.
+//
+// Budgets for the above, estimates that have not been counted from a
+// disassembly or measured, so they are not asserted. At 16MHz and
+// 31250 baud a sample is 510 cycles and a MIDI byte 5120 cycles; the
+// audio interrupt takes ~48 cycles to the PWM write and ~64 to sei(),
+// the receive interrupt ~80 in all (UART_RX_ISR in uart.h):
+//
+//  - masked audio plus one receive interrupt must stay under two byte
+//    times, or the third byte is lost from the USART FIFO
+//  - a receive interrupt plus the way to the PWM write must stay under
+//    half a sample, or the write misses the compare latch at TOP
+//  - a MIDI flood must leave rendering at least half the CPU, two
+//    receive interrupts per byte time at most
+//
+// make DEBUG=1 rxcheck runs a flood through the USART in simavr and
+// fails on a lost byte; make jitter shows the PWM write delay.
+
+// Cycles per MIDI byte (10 bits on the wire)
+#define MIDI_BYTE_CYCLES  (F_CPU * 10 / MIDI_BAUD_RATE)
 
-static uint16_t mapPhaseInc(uint16_t input) {
-  return (pgm_read_word(&antilogTable[input & 0x3f])) >> (input >> 6);
+static void audioOn() {
+#if defined(__AVR_ATmega8__)
+  // ATmega8 has different registers
+  TCCR2 = _BV(WGM20) | _BV(COM21) | _BV(CS20);
+  // Shared with Timer0 and Timer1
+  TIMSK |= _BV(TOIE2);
+#elif defined(__AVR_ATmega1280__)
+  TCCR3A = _BV(COM3C1) | _BV(WGM30);
+  TCCR3B = _BV(CS30);
+  TIMSK3 = _BV(TOIE3);
+#else
+  // Set up PWM to 31.25kHz, phase accurate
+  TCCR2A = _BV(COM2B1) | _BV(WGM20);
+  TCCR2B = _BV(CS20);
+  TIMSK2 = _BV(TOIE2);
+#endif
 }
 
-#include <math.h>
+#if AUDUINO_SLEEP
+static bool audioStopped;
+static uint16_t silentSince;
 
-constexpr double midiNoteToFreq(double p) {
-  return pow(2.0, (p - 69) / 12.0) * 440.0;
+// Timer clock off and the pin left floating, a pin held high or low
+// would put a step into the output
+static void audioOff() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    PWM_TIMSK &= ~_BV(PWM_TOIE);
+#if defined(__AVR_ATmega8__)
+    TCCR2 = 0;
+#elif defined(__AVR_ATmega1280__)
+    TCCR3B = 0;
+#else
+    TCCR2B = 0;
+#endif
+  }
+
+  PWM_DDR &= ~(1 << PWM_BIT);
+  audioStopped = true;
+  TRACE(TRACE_AUDIO_STOP, sampleClock);
 }
 
-constexpr uint16_t freqToInc(double f, double accSteps, double sr) {
-  // with rounding
-  return f * accSteps / sr + 0.5;
+static void audioResume() {
+  PWM_DDR |= 1 << PWM_BIT;
+  audioOn();
+  audioStopped = false;
+  TRACE(TRACE_AUDIO_RESUME, sampleClock);
 }
+#endif
 
-#define MIDI_TO_INC(p) freqToInc(midiNoteToFreq(p), 65536, 31250)
 
-// Stepped chromatic mapping
-//
-static const uint16_t midiTable[128] PROGMEM = {
-  MIDI_TO_INC(0), MIDI_TO_INC(1), MIDI_TO_INC(2), MIDI_TO_INC(3), MIDI_TO_INC(4), MIDI_TO_INC(5), MIDI_TO_INC(6), MIDI_TO_INC(7),
-  MIDI_TO_INC(8), MIDI_TO_INC(9), MIDI_TO_INC(10), MIDI_TO_INC(11), MIDI_TO_INC(12), MIDI_TO_INC(13), MIDI_TO_INC(14), MIDI_TO_INC(15),
-  MIDI_TO_INC(16), MIDI_TO_INC(17), MIDI_TO_INC(18), MIDI_TO_INC(19), MIDI_TO_INC(20), MIDI_TO_INC(21), MIDI_TO_INC(22), MIDI_TO_INC(23),
-  MIDI_TO_INC(24), MIDI_TO_INC(25), MIDI_TO_INC(26), MIDI_TO_INC(27), MIDI_TO_INC(28), MIDI_TO_INC(29), MIDI_TO_INC(30), MIDI_TO_INC(31),
-  MIDI_TO_INC(32), MIDI_TO_INC(33), MIDI_TO_INC(34), MIDI_TO_INC(35), MIDI_TO_INC(36), MIDI_TO_INC(37), MIDI_TO_INC(38), MIDI_TO_INC(39),
-  MIDI_TO_INC(40), MIDI_TO_INC(41), MIDI_TO_INC(42), MIDI_TO_INC(43), MIDI_TO_INC(44), MIDI_TO_INC(45), MIDI_TO_INC(46), MIDI_TO_INC(47),
-  MIDI_TO_INC(48), MIDI_TO_INC(49), MIDI_TO_INC(50), MIDI_TO_INC(51), MIDI_TO_INC(52), MIDI_TO_INC(53), MIDI_TO_INC(54), MIDI_TO_INC(55),
-  MIDI_TO_INC(56), MIDI_TO_INC(57), MIDI_TO_INC(58), MIDI_TO_INC(59), MIDI_TO_INC(60), MIDI_TO_INC(61), MIDI_TO_INC(62), MIDI_TO_INC(63),
-  MIDI_TO_INC(64), MIDI_TO_INC(65), MIDI_TO_INC(66), MIDI_TO_INC(67), MIDI_TO_INC(68), MIDI_TO_INC(69), MIDI_TO_INC(70), MIDI_TO_INC(71),
-  MIDI_TO_INC(72), MIDI_TO_INC(73), MIDI_TO_INC(74), MIDI_TO_INC(75), MIDI_TO_INC(76), MIDI_TO_INC(77), MIDI_TO_INC(78), MIDI_TO_INC(79),
-  MIDI_TO_INC(80), MIDI_TO_INC(81), MIDI_TO_INC(82), MIDI_TO_INC(83), MIDI_TO_INC(84), MIDI_TO_INC(85), MIDI_TO_INC(86), MIDI_TO_INC(87),
-  MIDI_TO_INC(88), MIDI_TO_INC(89), MIDI_TO_INC(90), MIDI_TO_INC(91), MIDI_TO_INC(92), MIDI_TO_INC(93), MIDI_TO_INC(94), MIDI_TO_INC(95),
-  MIDI_TO_INC(96), MIDI_TO_INC(97), MIDI_TO_INC(98), MIDI_TO_INC(99), MIDI_TO_INC(100), MIDI_TO_INC(101), MIDI_TO_INC(102), MIDI_TO_INC(103),
-  MIDI_TO_INC(104), MIDI_TO_INC(105), MIDI_TO_INC(106), MIDI_TO_INC(107), MIDI_TO_INC(108), MIDI_TO_INC(109), MIDI_TO_INC(110), MIDI_TO_INC(111),
-  MIDI_TO_INC(112), MIDI_TO_INC(113), MIDI_TO_INC(114), MIDI_TO_INC(115), MIDI_TO_INC(116), MIDI_TO_INC(117), MIDI_TO_INC(118), MIDI_TO_INC(119),
-  MIDI_TO_INC(120), MIDI_TO_INC(121), MIDI_TO_INC(122), MIDI_TO_INC(123), MIDI_TO_INC(124), MIDI_TO_INC(125), MIDI_TO_INC(126), MIDI_TO_INC(127),
+// Only listened to channels get here, still never index past parts
+static inline Part &partForChannel(uint8_t channel) {
+  uint8_t part = channelParts[(channel - 1) & 0x0f];
+
+  return parts[part < AUDUINO_PARTS ? part : 0];
+}
+
+static inline Part &partFor(const MidiMessage &message) {
+  return partForChannel(message.channel);
+}
+
+static void applyPatch(const Part &part) {
+  for (uint8_t i = 0; i < part.voiceCount; i++) {
+    voices[part.firstVoice + i].applyPatch(part.patch);
+  }
+}
+
+// Round robin within the part's voices
+static Voice &allocateVoice(Part &part) {
+  Voice &voice = voices[part.firstVoice + part.nextVoice];
+
+  if (++part.nextVoice == part.voiceCount) {
+    part.nextVoice = 0;
+  }
+
+  return voice;
+}
+
+// Waits for the ISR if the queue is full, at most NOTE_LATENCY samples
+static NoteEvent &nextNoteEvent(uint16_t time, Voice &voice) {
+  uint8_t head = noteEventHead;
+
+#if AUDUINO_SLEEP
+  // The sample clock stood still, time is NOTE_LATENCY from now
+  if (audioStopped) {
+    audioResume();
+  }
+#endif
+
+  // Any interrupt wakes us, the audio one frees a slot within a sample
+  while (((head + 1) & (NOTE_EVENTS - 1)) == noteEventTail) {
+    sleep_mode();
+  }
+
+  NoteEvent &event = noteEvents[head];
+  event.time = time + NOTE_LATENCY;
+  event.voice = &voice - voices;
+  return event;
+}
+
+static inline void pushNoteEvent() {
+  noteEventHead = (noteEventHead + 1) & (NOTE_EVENTS - 1);
+}
+
+static inline void applyNoteEvent(const NoteEvent &event) {
+  Voice &voice = voices[event.voice];
+
+  TRACE(TRACE_NOTE_EVENT, event.voice << 8 | event.velocity);
+
+  if (event.velocity) {
+    voice.note.gate = Note::OPEN;
+
+    voice.env.amp = event.velocity << 8;
+    voice.env.decay = event.envDecay;
+    voice.env.divider = event.envDivider;
+
+    voice.sync[0].setInc(event.syncInc[0]);
+    voice.sync[1].setInc(event.syncInc[1]);
+  } else {
+    voice.note.gate = Note::CLOSED;
+  }
+}
+
+// Note numbers are bookkept here in loop(), gates are left to the ISR
+static void releaseNote(const Part &part, uint8_t number, uint16_t time) {
+  TRACE(TRACE_NOTE_OFF, number);
+
+  for (uint8_t i = 0; i < part.voiceCount; i++) {
+    Voice &voice = voices[part.firstVoice + i];
+
+    if (voice.note.number == number) {
+      voice.note.number = 0xff;
+      nextNoteEvent(time, voice).velocity = 0;
+      pushNoteEvent();
+    }
+  }
+}
+
+// All Notes Off, gates close as for Note Off and the envelopes release.
+// A stopped audio timer has nothing sounding, it is not woken for this.
+static void releaseAllNotes(const Part &part, uint16_t time) {
+  for (uint8_t i = 0; i < part.voiceCount; i++) {
+    Voice &voice = voices[part.firstVoice + i];
+
+    voice.note.number = 0xff;
+#if AUDUINO_SLEEP
+    if (audioStopped) {
+      continue;
+    }
+#endif
+    nextNoteEvent(time, voice).velocity = 0;
+    pushNoteEvent();
+  }
+}
+
+// Sound parameters reachable over MIDI. NRPN n sets parameter n,
+// controllers 0 - 31 are mapped to parameters with controllerMap.
+enum Parameter : uint8_t {
+  PARAM_NONE,
+  PARAM_GRAIN1_PITCH,
+  PARAM_GRAIN2_PITCH,
+  PARAM_GRAIN1_DECAY,
+  PARAM_GRAIN2_DECAY,
+  // both grain decays at once, grain 2 at half rate
+  PARAM_GRAIN_DECAYS,
+  PARAM_ENV_DECAY,
+  PARAM_ENV_DIVIDER,
+  // global, 12bit mask and root note of the scale grain pitches are
+  // quantised to, mask 0 for smooth pitch
+  PARAM_SCALE_MASK,
+  PARAM_SCALE_ROOT,
+  PARAMETERS,
 };
-/*
-  17,18,19,20,22,23,24,26,27,29,31,32,34,36,38,41,43,46,48,51,54,58,61,65,69,73,
-  77,82,86,92,97,103,109,115,122,129,137,145,154,163,173,183,194,206,218,231,
-  244,259,274,291,308,326,346,366,388,411,435,461,489,518,549,581,616,652,691,
-  732,776,822,871,923,978,1036,1097,1163,1232,1305,1383,1465,1552,1644,1742,
-  1845,1955,2071,2195,2325,2463,2610,2765,2930,3104,3288,3484,3691,3910,4143,
-  4389,4650,4927,5220,5530,5859,6207,6577,6968,7382,7821,8286,8779,9301,9854,
-  10440,11060,11718,12415,13153,13935,14764,15642,16572,17557,18601,19708,20879,
-  22121,23436,24830,26306
+
+static const uint8_t defaultControllerMap[32] PROGMEM = {
+  PARAM_NONE, PARAM_GRAIN_DECAYS, PARAM_NONE, PARAM_NONE,     // 1: mod wheel
+  PARAM_NONE, PARAM_NONE, PARAM_NONE, PARAM_NONE,
+  PARAM_NONE, PARAM_NONE, PARAM_NONE, PARAM_NONE,
+  PARAM_NONE, PARAM_NONE, PARAM_NONE, PARAM_NONE,
+  PARAM_GRAIN1_PITCH, PARAM_GRAIN2_PITCH, PARAM_NONE, PARAM_NONE, // 16, 17: general purpose 1, 2
+  PARAM_NONE, PARAM_NONE, PARAM_NONE, PARAM_NONE,
+  PARAM_NONE, PARAM_NONE, PARAM_NONE, PARAM_NONE,
+  PARAM_NONE, PARAM_NONE, PARAM_NONE, PARAM_NONE,
 };
-*/
 
-static uint16_t mapMidi(uint16_t input) {
-  return pgm_read_word(&midiTable[(1023-input) >> 3]);
+static uint8_t controllerMap[32];
+
+static uint16_t pitchToInc(uint16_t value) {
+  return Scale.getMask() != SCALE_OFF ? Scale.inc(value) : Tuning.interpolate(value);
 }
 
-// Stepped Pentatonic mapping
-//
-static const uint16_t pentatonicTable[54] PROGMEM = {
-  0,19,22,26,29,32,38,43,51,58,65,77,86,103,115,129,154,173,206,231,259,308,346,
-  411,461,518,616,691,822,923,1036,1232,1383,1644,1845,2071,2463,2765,3288,
-  3691,4143,4927,5530,6577,7382,8286,9854,11060,13153,14764,16572,19708,22121,26306
-};
+// 14bit value, 7bit sources are shifted up
+static void setParameter(Part &part, uint8_t parameter, uint16_t value) {
+  Patch &patch = part.patch;
 
-static uint16_t mapPentatonic(uint16_t input) {
-  uint8_t value = (1023-input) * 53 >> 10; // ~= / (53/1024)
-  return pgm_read_word(&pentatonicTable[value]);
+  switch (parameter) {
+    case PARAM_GRAIN1_PITCH: patch.grainInc[0] = pitchToInc(value); break;
+    case PARAM_GRAIN2_PITCH: patch.grainInc[1] = pitchToInc(value); break;
+    case PARAM_GRAIN1_DECAY: patch.grainDecay[0] = value >> 7; break;
+    case PARAM_GRAIN2_DECAY: patch.grainDecay[1] = value >> 7; break;
+    case PARAM_GRAIN_DECAYS:
+      patch.grainDecay[0] = value >> 10;
+      patch.grainDecay[1] = value >> 11;
+      break;
+    case PARAM_ENV_DECAY: patch.envDecay = value >> 7; break;
+    case PARAM_ENV_DIVIDER: patch.envDivider = value >> 11; break;
+    case PARAM_SCALE_MASK: Scale.set(value, Scale.getRoot()); return;
+    case PARAM_SCALE_ROOT: Scale.set(Scale.getMask(), value >> 7); return;
+    default: return;
+  }
+
+  applyPatch(part);
 }
 
+static inline uint16_t now() {
+  uint16_t time;
 
-static void audioOn() {
-#if defined(__AVR_ATmega8__)
-  // ATmega8 has different registers
-  TCCR2 = _BV(WGM20) | _BV(COM21) | _BV(CS20);
-  TIMSK = _BV(TOIE2);
-#elif defined(__AVR_ATmega1280__)
-  TCCR3A = _BV(COM3C1) | _BV(WGM30);
-  TCCR3B = _BV(CS30);
-  TIMSK3 = _BV(TOIE3);
-#else
-  // Set up PWM to 31.25kHz, phase accurate
-  TCCR2A = _BV(COM2B1) | _BV(WGM20);
-  TCCR2B = _BV(CS20);
-  TIMSK2 = _BV(TOIE2);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    time = sampleClock;
+  }
+
+  return time;
+}
+
+// Silence the part's voices and forget their notes in one go, the ISR
+// must not see a half cleared voice
+static void resetVoices(Part &part) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    memset(&voices[part.firstVoice], 0, part.voiceCount * sizeof(Voice));
+    part.nextVoice = 0;
+    applyPatch(part);
+
+    // Pending events of the part must not reopen gates
+    for (auto &event : noteEvents) {
+      if (static_cast<uint8_t>(event.voice - part.firstVoice) < part.voiceCount) {
+        event.velocity = 0;
+      }
+    }
+  }
+}
+
+static void checkOverload() {
+  uint16_t time = now();
+
+  if (static_cast<uint16_t>(time - overloadWindowStart) < OVERLOAD_WINDOW) {
+    return;
+  }
+
+  overloadWindowStart = time;
+
+  uint16_t count;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    count = audioOverruns;
+  }
+
+  bool overran = count != overrunsSeen;
+  overrunsSeen = count;
+
+  if (overran) {
+    calmWindows = 0;
+
+    if (quality < QUALITY_LOWEST) {
+      quality++;
+      overloadReport = true;
+      TRACE(TRACE_QUALITY, quality);
+    }
+  } else if (quality > QUALITY_FULL && ++calmWindows == OVERLOAD_CALM) {
+    calmWindows = 0;
+    quality--;
+    overloadReport = true;
+    TRACE(TRACE_QUALITY, quality);
+  }
+}
+
+// Ranked in loop() rather than in the ISR, a new note waits at most a
+// pass of loop() to be heard at QUALITY_VOICE_LIMIT. Ties go to the
+// lower index.
+static void rankVoices() {
+  if (quality < QUALITY_VOICE_LIMIT) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < VOICES; i++) {
+    uint8_t value = voices[i].env.value();
+    uint8_t louder = 0;
+
+    for (uint8_t j = 0; j < VOICES; j++) {
+      uint8_t other = voices[j].env.value();
+
+      if (other > value || (other == value && j < i)) {
+        louder++;
+      }
+    }
+
+    voiceCapped[i] = louder >= AUDUINO_OVERLOAD_VOICES;
+  }
+}
+
+#if SYSEX_DUMP
+// F0 7D 41 03 01 quality overruns F7, overruns in 7 bits
+static void reportOverload() {
+  if (!overloadReport) {
+    return;
+  }
+
+  const uint8_t status[] = { 0x01, quality, static_cast<uint8_t>(overrunsSeen) };
+
+  if (SysExDump.sendStatus(status, sizeof(status))) {
+    overloadReport = false;
+  }
+}
+#endif
+
+#if AUDUINO_SLEEP
+static bool silent() {
+  if (noteEventHead != noteEventTail) {
+    return false;
+  }
+
+  for (auto &voice : voices) {
+    if (!voice.idle()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Work loop() must still do while the audio is stopped
+static bool busy() {
+#if SYSEX_DUMP
+  if (SysExDump.sending()) {
+    return true;
+  }
+#endif
+#if TUNING_TABLE
+  if (Tuning.persisting()) {
+    return true;
+  }
+#endif
+#if MIDI_TRANSMIT
+  if (Midi.transmitPending()) {
+    return true;
+  }
+#endif
+  return false;
+}
+
+// Idle sleep keeps the timers and the USART running, any interrupt
+// wakes us. Once stopped only MIDI input (and Timer0 with the core)
+// does; the next note restarts the audio in nextNoteEvent(). Output and
+// EEPROM writes are polled from loop() with no interrupt of their own,
+// so while stopped we stay awake until they are done.
+static void sleepUntilInterrupt() {
+  if (audioStopped) {
+    if (busy()) {
+      return;
+    }
+  } else {
+    uint16_t time = now();
+
+    if (!silent() || busy()) {
+      silentSince = time;
+    } else if (static_cast<uint16_t>(time - silentSince) >= AUDUINO_SILENCE) {
+      audioOff();
+    }
+  }
+
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  cli();
+
+  // A byte that arrived after serialEventRun() must not wait for the
+  // next interrupt, there may not be one. sei() takes effect after
+  // sleep_cpu().
+  if (!MidiSerial.available()) {
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+  }
+
+  sei();
+}
 #endif
+
+static void resetAllVoices() {
+  for (auto &part : parts) {
+    resetVoices(part);
+  }
 }
 
+// Channels without a part are left to the rest of the chain
+static void listenChannels() {
+  uint16_t channelMask = 0;
+
+  for (uint8_t i = 0; i < 16; i++) {
+    if (channelParts[i] >= AUDUINO_PARTS) {
+      channelParts[i] = NO_PART;
+    } else {
+      channelMask |= 1U << i;
+    }
+  }
+
+  Midi.listen(channelMask);
+}
+
+// Power on maps, a corrupt SysEx dump falls back to them too
+static void setupMaps() {
+  memcpy_P(controllerMap, defaultControllerMap, sizeof(controllerMap));
+
+  // single part plays everything (omni), otherwise part n plays
+  // channel n + 1
+  for (uint8_t i = 0; i < 16; i++) {
+    channelParts[i] = AUDUINO_PARTS > 1 ? i : 0;
+  }
+}
+
+#if SYSEX_DUMP
+enum DumpRegion {
+  DUMP_PATCHES = 1,
+  DUMP_CONTROLLER_MAP,
+  DUMP_CHANNEL_PARTS,
+  DUMP_TUNING,
+};
+
+// Keep tools/sysex.py in sync
+static const SysExRegion dumpRegions[] PROGMEM = {
+  { DUMP_PATCHES, AUDUINO_PARTS, sizeof(Patch), sizeof(Part), &parts[0].patch },
+  { DUMP_CONTROLLER_MAP, 1, sizeof(controllerMap), 0, controllerMap },
+  { DUMP_CHANNEL_PARTS, 1, sizeof(channelParts), 0, channelParts },
+#if TUNING_TABLE
+  { DUMP_TUNING, 1, sizeof(Tuning.table), 0, Tuning.table },
+#endif
+};
+#endif
+
+#if MIDI_SYSTEM_COMMON
+// SysEx by ID: our own dumps and Universal (tuning) messages
+static uint8_t sysExId;
+
+static void setupSysEx() {
+  Midi.handlers.systemExclusive = [] (MidiMessage &message) {
+    sysExId = message.data[0];
+#if SYSEX_DUMP
+    if (sysExId == _SysExDump::manufacturerId) {
+      SysExDump.receiveStart(sysExId);
+    }
+#endif
+#if TUNING_TABLE
+    if (sysExId == 0x7e || sysExId == 0x7f) {
+      Tuning.receiveStart(sysExId);
+    }
+#endif
+  };
+  Midi.handlers.systemExclusiveData = [] (uint8_t data) {
+#if SYSEX_DUMP
+    if (sysExId == _SysExDump::manufacturerId) {
+      SysExDump.receive(data);
+    }
+#endif
+#if TUNING_TABLE
+    if (sysExId == 0x7e || sysExId == 0x7f) {
+      Tuning.receive(data);
+    }
+#endif
+  };
+  Midi.handlers.endOfExclusive = [] (MidiMessage &) {
+#if SYSEX_DUMP
+    if (sysExId == _SysExDump::manufacturerId) {
+      SysExDump.receiveEnd();
+    }
+#endif
+#if TUNING_TABLE
+    if (sysExId == 0x7e || sysExId == 0x7f) {
+      Tuning.receiveEnd();
+    }
+#endif
+    sysExId = 0;
+  };
+  Midi.handlers.systemExclusiveAbort = [] (uint8_t) {
+#if SYSEX_DUMP
+    if (sysExId == _SysExDump::manufacturerId) {
+      SysExDump.receiveAbort();
+    }
+#endif
+#if TUNING_TABLE
+    if (sysExId == 0x7e || sysExId == 0x7f) {
+      Tuning.receiveEnd();
+    }
+#endif
+    sysExId = 0;
+  };
+}
+#endif
+
+static void setupParts() {
+  for (uint8_t i = 0; i < AUDUINO_PARTS; i++) {
+    parts[i].patch = defaultPatch;
+    parts[i].firstVoice = i * AUDUINO_VOICES_PER_PART;
+    parts[i].voiceCount = AUDUINO_VOICES_PER_PART;
+    parts[i].nextVoice = 0;
+    applyPatch(parts[i]);
+  }
+
+  setupMaps();
+
+  Midi.begin();
+  MidiSerial.clock = &sampleClock;
+#if MIDI_THRU
+  Midi.thru(_Midi::ThruForeign);
+#endif
+  listenChannels();
+
+#if SYSEX_DUMP
+  SysExDump.begin(dumpRegions, sizeof(dumpRegions) / sizeof(*dumpRegions));
+#if MIDI_THRU
+  Midi.listenSysEx(_SysExDump::manufacturerId);
+#endif
+  SysExDump.loaded = [] (bool ok) {
+    TRACE(TRACE_SYSEX_LOADED, ok);
+
+    // The dump was decoded in place, a bad one has overwritten every
+    // region: back to the power on state and the stored tuning
+    if (!ok) {
+      for (auto &part : parts) {
+        part.patch = defaultPatch;
+      }
+      setupMaps();
+    }
+
+    for (auto &part : parts) {
+      applyPatch(part);
+    }
+    listenChannels();
+#if TUNING_TABLE
+    if (ok) {
+      Tuning.changed();
+    } else {
+      Tuning.revert();
+    }
+#endif
+  };
+#endif
+#if MIDI_SYSTEM_COMMON
+  setupSysEx();
+#endif
+}
 
 void setup() {
   SETUP_DEBUG();
-  pinMode(PWM_PIN,OUTPUT);
+  PWM_DDR |= 1 << PWM_BIT;
   audioOn();
-  pinMode(LED_PIN,OUTPUT);
+  LED_DDR |= 1 << LED_BIT;
+#if AUDUINO_BARE_METAL && defined(power_adc_disable)
+  // Nothing uses them without the core
+  power_adc_disable();
+  power_spi_disable();
+  power_twi_disable();
+  power_timer0_disable();
+# if !SIM_FEED && !defined(DEBUG)
+  power_timer1_disable();
+# endif
+#endif
+  Tuning.begin();
+  Scale.set(SCALE_OFF, 0);
   // setup midi
-  Midi.begin();
+  setupParts();
   // set handlers
   Midi.handlers.noteOn = [] (MidiMessage &message) {
     // no bounds checking, midi should not produce
     // note values higher than 127
     uint8_t number = message.data[0];
     uint8_t velocity = message.data[1];
+    Part &part = partFor(message);
 
     if (velocity) {
-      voices[0].note.number = number;
-      voices[0].note.velocity = velocity;
-      voices[0].note.gate = Note::OPEN;
-
-      voices[0].env.amp = velocity << 8;
-      voices[0].env.decay = 1;
-      voices[0].env.divider = 4;
-
-      voices[0].sync[0].setInc(pgm_read_word(&midiTable[voices[0].note.number - 24]));
-      voices[0].sync[1].setInc(pgm_read_word(&midiTable[voices[0].note.number - 17]));
-    } else if (voices[0].note.number == number) {
-      voices[0].note.gate = Note::CLOSED;
+      TRACE(TRACE_NOTE_ON, number << 8 | velocity);
+
+      Voice &voice = allocateVoice(part);
+
+      voice.note.number = number;
+      voice.note.velocity = velocity;
+
+      NoteEvent &event = nextNoteEvent(message.time, voice);
+      event.velocity = velocity;
+      event.envDecay = part.patch.envDecay;
+      event.envDivider = part.patch.envDivider;
+      event.syncInc[0] = Tuning.inc(number, part.patch.syncTranspose[0]);
+      event.syncInc[1] = Tuning.inc(number, part.patch.syncTranspose[1]);
+      pushNoteEvent();
+    } else {
+      releaseNote(part, number, message.time);
     }
   };
   Midi.handlers.noteOff = [] (MidiMessage &message) {
-    if (voices[0].note.number == message.data[0]) {
-      voices[0].note.gate = Note::CLOSED;
+    releaseNote(partFor(message), message.data[0], message.time);
+  };
+#if MIDI_HIGH_RESOLUTION
+  Midi.handlers.controlChange14 = [] (uint8_t channel, uint16_t controller, uint16_t value) {
+    setParameter(partForChannel(channel), controllerMap[controller], value);
+  };
+  Midi.handlers.nonRegisteredParameter = [] (uint8_t channel, uint16_t parameter, uint16_t value) {
+    if (parameter < PARAMETERS) {
+      setParameter(partForChannel(channel), parameter, value);
     }
   };
+#else
   Midi.handlers.controlChange = [] (MidiMessage &message) {
     uint8_t controller = message.data[0];
-    uint8_t value = message.data[1];
-
-    switch (controller) {
-      case 1:
-        // mod wheel
-        voices[0].grains[0].env.decay = value >> 3;
-        voices[0].grains[1].env.decay = value >> 4;
-        break;
-      case 16: voices[0].grains[0].phase.setInc(pgm_read_word(&midiTable[value])); break;
-      //case 21: grains[0].env.decay = value << 1; break;
-      case 17: voices[0].grains[1].phase.setInc(pgm_read_word(&midiTable[value])); break;
-      //case 23: grains[1].env.decay = value; break;
+
+    if (controller < sizeof(controllerMap)) {
+      setParameter(partFor(message), controllerMap[controller], message.data[1] << 7);
     }
   };
+#endif
   Midi.handlers.pitchWheelChange = [] (MidiMessage &message) {
     // 14bit
     uint16_t value = message.data[1] << 7 | message.data[0];
-    voices[0].sync[0].modulate(value);
-    voices[0].sync[1].modulate(value);
+    const Part &part = partFor(message);
+
+    for (uint8_t i = 0; i < part.voiceCount; i++) {
+      voices[part.firstVoice + i].sync[0].modulate(value);
+      voices[part.firstVoice + i].sync[1].modulate(value);
+    }
+  };
+#if MIDI_CHANNEL_MODE
+  Midi.handlers.allSoundOff = [] (MidiMessage &message) {
+    resetVoices(partFor(message));
+  };
+  Midi.handlers.allNotesOff = [] (MidiMessage &message) {
+    releaseAllNotes(partFor(message), message.time);
   };
+  Midi.handlers.resetAllControllers = [] (MidiMessage &message) {
+    Part &part = partFor(message);
+
+    part.patch = defaultPatch;
+    applyPatch(part);
+
+    for (uint8_t i = 0; i < part.voiceCount; i++) {
+      voices[part.firstVoice + i].sync[0].modulate(0x2000);
+      voices[part.firstVoice + i].sync[1].modulate(0x2000);
+    }
+  };
+#endif
+#if MIDI_SYSTEM_REAL_TIME
+  Midi.handlers.activeSensing = [] (MidiMessage &) {
+    activeSensingTime = now();
+    activeSensing = true;
+  };
+  Midi.handlers.reset = [] (MidiMessage &) {
+    activeSensing = false;
+    resetAllVoices();
+  };
+#endif
+
+  SETUP_SIM_FEED();
 }
 
+#ifdef DEBUG
+// Received MIDI bytes lost, make rxcheck expects none
+static void traceMidiLoss() {
+  static uint8_t overruns;
+  static uint8_t dropped;
+
+  if (MidiSerial.overruns() != overruns) {
+    overruns = MidiSerial.overruns();
+    TRACE(TRACE_MIDI_OVERRUN, overruns);
+  }
+
+  if (MidiSerial.dropped() != dropped) {
+    dropped = MidiSerial.dropped();
+    TRACE(TRACE_MIDI_DROPPED, dropped);
+  }
+}
+#endif
+
 void loop() {
   // The loop is pretty simple - it just updates the parameters for the oscillators.
   //
   // Avoid using any functions that make extensive use of interrupts, or turn interrupts off.
   // They will cause clicks and poops in the audio.
+
+  DEBUG_POLL();
+#ifdef DEBUG
+  traceMidiLoss();
+#endif
+
+#if SYSEX_DUMP
+  SysExDump.poll();
+#endif
+#if TUNING_TABLE
+  Tuning.poll();
+#endif
+#if MIDI_TRANSMIT
+  Midi.transmit();
+#endif
+
+  checkOverload();
+  rankVoices();
+#if SYSEX_DUMP
+  reportOverload();
+#endif
+
+  // Sender went away, cable pulled or such
+  if (activeSensing && static_cast<uint16_t>(now() - activeSensingTime) > ACTIVE_SENSING_TIMEOUT) {
+    activeSensing = false;
+    resetAllVoices();
+  }
  
   // Smooth frequency mapping
   //syncPhaseInc = mapPhaseInc(analogRead(SYNC_CONTROL)) / 4;
  
-  // Stepped mapping to MIDI notes: C, Db, D, Eb, E, F...
-  //syncPhaseInc = mapMidi(analogRead(SYNC_CONTROL));
- 
-  // Stepped pentatonic mapping: D, E, G, A, B
-  //syncPhase.inc = mapPentatonic(analogRead(SYNC_CONTROL));
+  // Stepped mapping to the scale set over NRPN, chromatic by default.
+  // Pentatonic D, E, G, A, B: Scale.set(SCALE_PENTATONIC, 7)
+  //syncPhaseInc = mapScale(analogRead(SYNC_CONTROL));
 
   //grains[0].phase.inc = mapPhaseInc(analogRead(GRAIN_FREQ_CONTROL)) / 2;
   //grains[0].env.decay = analogRead(GRAIN_DECAY_CONTROL) / 8;
   //grains[1].phase.inc = mapPhaseInc(analogRead(GRAIN2_FREQ_CONTROL)) / 2;
   //grains[1].env.decay = analogRead(GRAIN2_DECAY_CONTROL) / 4;
+
+#if AUDUINO_SLEEP
+  sleepUntilInterrupt();
+#endif
 }
 
 ISR(PWM_INTERRUPT)
 {
-  ++voices[0].sync[0];
-  ++voices[0].sync[1];
+  // Output to PWM (this is faster than using analogWrite)
+  PWM_VALUE = pwmValue;
+  // Cycles since the overflow at BOTTOM
+  JITTER_TRACE(PWM_COUNT);
+  BRIDGE_CAPTURE(pwmValue);
 
-  if (voices[0].sync[0].hasOverflowed()) {
-    // Time to start the next grain
-    voices[0].grains[0].reset();
-    LED_PORT ^= 1 << LED_BIT; // Faster than using digitalWrite
-  }
+  // The receive interrupt stamps bytes with the clock, not torn halfway
+  uint16_t time = ++sampleClock;
+
+  // Render with MIDI receive allowed in, see interrupt scheme above
+  PWM_TIMSK &= ~_BV(PWM_TOIE);
+  sei();
+
+  int16_t output = 0;
 
-  if (voices[0].sync[1].hasOverflowed()) {
-    voices[0].grains[1].reset();
+  // At most one note event per sample, a chord is spread over a few
+  // samples
+  uint8_t tail = noteEventTail;
+  if (tail != noteEventHead && static_cast<int16_t>(time - noteEvents[tail].time) >= 0) {
+    applyNoteEvent(noteEvents[tail]);
+    noteEventTail = (tail + 1) & (NOTE_EVENTS - 1);
   }
- 
-  // Increment the phase of the grain oscillators
-  ++voices[0].grains[0].phase;
-  ++voices[0].grains[1].phase;
 
-  uint16_t output;
-  output =  voices[0].grains[0].getSample();
-  output += voices[0].grains[1].getSample();
+  uint8_t level = quality;
+
+  for (uint8_t i = 0; i < VOICES; i++) {
+    Voice &voice = voices[i];
+
+    if (level >= QUALITY_VOICE_LIMIT) {
+      if (voice.idle()) {
+        continue;
+      }
+
+      if (voiceCapped[i]) {
+        voice.skip();
+        continue;
+      }
+    }
 
-  // Make the grain amplitudes decay by a factor every sample (exponential decay)
-  voices[0].grains[0].env.tick();
-  voices[0].grains[1].env.tick();
+    output += voice.render(level) >> VOICE_MIX_SHIFT;
+  }
 
-  // It's ok to leave the PWM to what ever value it is when gate closes,
-  // since HPF should remove DC voltages.
-  if (voices[0].note.gate == Note::CLOSED) {
-    voices[0].env.tick();
+  if (voices[0].sync[0].hasOverflowed()) {
+    LED_PORT ^= 1 << LED_BIT; // Faster than using digitalWrite
   }
 
-  // Scale and shift output to the available signed range for amplitude calculations
-  int8_t scaled_output = static_cast<uint8_t>(output >> 7) - 128;
+  pwmValue = static_cast<uint8_t>(output >> 8) + 128;
 
-  // Output to PWM (this is faster than using analogWrite)
-  // 2 * 127 * 255  + 2 * 255  = 65280,  well within unsigned 16bit limits
-  // 2 * 127 * -128 + 2 * -128 = -32768, ok
-  // 2 * 127 * 127  + 2 * 127  = 32512,  ok
-  // value = output * (velocity + 1) / (127 + 1)
-  //       = output * (velocity + 1) * 2 / ((127 + 1) * 2)
-  //       = output * (2 * velocity + 2) / 256
-  //       = (2 * velocity * output + 2 * output) / 256
-  //
-  // mul() from grain.h, grain.hpp
-  int16_t scaled_output_x2 = mulsu(scaled_output, 2);
-  scaled_output_x2 += scaled_output_x2 * voices[0].env.value();
-  PWM_VALUE = static_cast<uint8_t>(scaled_output_x2 >> 8) + 128;
+  cli();
+
+  // Next period already began, its sample will be late
+  if (PWM_TIFR & _BV(PWM_TOV)) {
+    audioOverruns++;
+    TRACE(TRACE_OVERRUN, audioOverruns);
+  }
+
+  PWM_TIMSK |= _BV(PWM_TOIE);
 }
@@ -4,33 +4,52 @@
 //
 // ChangeLog:
 // 19 Oct 2012: Use AVR stdio stream methods
+// 17 Oct 2026: Drain the binary trace instead of stdio
 
-#include <stdio.h>
+#include <avr/io.h>
+#include <util/atomic.h>
 #include <stdint.h>
 #include "debug.h"
 
 static volatile uint8_t *_port = reinterpret_cast<volatile uint8_t *>(DEBUGPORT);
-static volatile uint8_t *_pin  = reinterpret_cast<volatile uint8_t *>(DEBUGPIN);
 
-extern "C" {
+TraceRecord traceBuffer[TRACE_SIZE];
+volatile uint8_t traceHead;
+volatile uint8_t traceTail;
+volatile uint8_t traceLost;
 
-	static int simulavr_fputc(const char c, FILE *stream) {
-		*_port = c;
-		return c;
-	}
+// Timer1 free running at F_CPU for the stamps
+void setup_debug() {
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+}
+
+static void write(uint8_t id, uint16_t time, uint16_t data) {
+	*_port = id;
+	*_port = time;
+	*_port = time >> 8;
+	*_port = data;
+	*_port = data >> 8;
+}
 
-	static int simulavr_fgetc(FILE *stream) {
-		return *_pin;
+// Records go out little endian: id, time, data
+void poll_debug() {
+	uint8_t lost;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		lost = traceLost;
+		traceLost = 0;
 	}
 
-}
+	if (lost) {
+		write(TRACE_LOST, TCNT1, lost);
+	}
 
-static FILE _stderr;
+	uint8_t tail = traceTail;
 
-void setup_debug() {
-	fdev_setup_stream(&_stderr,
-		simulavr_fputc,
-		simulavr_fgetc,
-		_FDEV_SETUP_WRITE | _FDEV_SETUP_READ);
-	stderr = &_stderr;
+	while (tail != traceHead) {
+		const TraceRecord &record = traceBuffer[tail];
+		write(record.id, record.time, record.data);
+		traceTail = tail = (tail + 1) & (TRACE_SIZE - 1);
+	}
 }
@@ -4,8 +4,23 @@
 //
 // ChangeLog:
 // 12 Oct 2012: System Common and Real time made optional
+// 17 Oct 2026: Channel mask for multi-timbral use
+// 17 Oct 2026: Filter channels at status byte, skip foreign data bytes
+// 17 Oct 2026: Baud rate divisor computed at compile time
+// 17 Oct 2026: Soft THRU
+// 17 Oct 2026: 14bit controller pairs, RPN and NRPN
+// 17 Oct 2026: Message timestamps
+// 17 Oct 2026: Streaming SysEx receive, transmit path split from THRU
+// 17 Oct 2026: Own receiver for bare metal builds
+// 17 Oct 2026: Uart driver replaces HardwareSerial
+// 17 Oct 2026: canSend() for several bytes
+// 17 Oct 2026: transmitPending()
+// 17 Oct 2026: Trace instead of DEBUG_WRITE
+// 17 Oct 2026: Stamps taken in the receive interrupt
+// 17 Oct 2026: THRU keeps our own SysEx back in ThruForeign mode
+// 17 Oct 2026: Own messages only between forwarded ones
+// 17 Oct 2026: systemExclusiveAbort when a status byte cuts SysEx short
 
-#include <Arduino.h>
 #include <avr/pgmspace.h>
 #include "midi.h"
 #include "debug.h"
@@ -14,22 +29,39 @@
 _Midi Midi;
 
 //---------------------------------------------------------//
-// Choose serial here (Serial, Serial1, Serial2 or Serial3)
-static auto &serial = Serial;
+// Choose the USART with MIDI_USART in midi.h
+MidiUart MidiSerial;
+
+UART_RX_ISR(MIDI_USART, MidiSerial)
 
 #if MIDI_HOOK_SERIAL_EVENT
-// Choose serial event callback here
-void serialEvent() {
-//void serialEvent1() {
-//void serialEvent2() {
-//void serialEvent3() {
-	while (serial.available()) {
-		Midi.eventHandler(serial.read());
+// Called after each loop(), by the core's main() or runtime.cpp. Also
+// keeps HardwareSerial and its serialEventRun() out of the link.
+void serialEventRun() {
+	while (MidiSerial.available()) {
+		uint16_t time = MidiSerial.time();
+		Midi.eventHandler(MidiSerial.read(), time);
 	}
 }
 #endif
 //---------------------------------------------------------//
 
+// Double speed mode divisor, rounded to nearest
+static constexpr unsigned long ubrr =
+	(F_CPU + 4UL * MIDI_BAUD_RATE) / (8UL * MIDI_BAUD_RATE) - 1;
+static constexpr unsigned long actualBaudRate = F_CPU / (8UL * (ubrr + 1));
+static constexpr unsigned long baudRateError =
+	(actualBaudRate > MIDI_BAUD_RATE
+		? actualBaudRate - MIDI_BAUD_RATE
+		: MIDI_BAUD_RATE - actualBaudRate) * 1000UL / MIDI_BAUD_RATE;
+
+static_assert(F_CPU / (8UL * MIDI_BAUD_RATE) >= 1,
+	"MIDI_BAUD_RATE too high for F_CPU");
+static_assert(ubrr <= 0x0FFF,
+	"MIDI_BAUD_RATE too low for F_CPU");
+static_assert(baudRateError <= MIDI_BAUD_TOLERANCE,
+	"MIDI_BAUD_RATE cannot be generated from F_CPU within MIDI_BAUD_TOLERANCE");
+
 inline constexpr uint8_t denseIndexFromStatus(uint8_t status) {
 	return status < 0xF0
 		// Channel Voice: 0x00 - 0x06
@@ -42,21 +74,210 @@ inline constexpr uint8_t channelFromStatus(uint8_t status) {
 	return (status & 0x0F) + 1;
 }
 
-// Work around buggy avr-libc PSTR
-#ifdef DEBUG
-static const char beginFmtStr[] PROGMEM = "_Midi::begin(channel = %d)\n";
-#endif
+// Variable shifts are loops on AVR, a lookup is constant time
+static const uint16_t channel_bit_lookup[16] PROGMEM = {
+	0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080,
+	0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000, 0x8000,
+};
+
+inline uint16_t channelBitFromStatus(uint8_t status) {
+	return pgm_read_word(&channel_bit_lookup[status & 0x0F]);
+}
 
 void _Midi::begin(int8_t channel_) {
-	DEBUG_WRITE_P(beginFmtStr, channel_);
-	serial.begin(baudRate);
-	channel = channel_;
+	TRACE(TRACE_MIDI_BEGIN, channel_);
+	MidiSerial.begin(ubrr);
+	listen(channel_ ? channelBitFromStatus(channel_ - 1) : 0xFFFF);
 	dataBufferPosition = 0;
 	currentMessage = 0;
+#if MIDI_TIMESTAMP
+	messageTime = 0;
+	stampNext = false;
+#endif
+#if MIDI_HIGH_RESOLUTION
+	pairController = 0xFF;
+	parameterMsb = parameterLsb = 0x7F;
+	parameterChannel = 0;
+	parameterValue = 0;
+#endif
+#if MIDI_TRANSMIT
+	txHead = txTail = 0;
+#endif
+#if MIDI_THRU
+	thruMode = ThruOff;
+	thruData = false;
+	thruSysExPending = false;
+	sysExId = 0xFF;
+	thruPending = 0;
+	thruStatus = 0;
+	thruRestate = false;
+#endif
+}
+
+void _Midi::listen(uint16_t channelMask) {
+	channels = channelMask;
+}
+
+#if MIDI_THRU
+void _Midi::thru(Thru mode) {
+	thruMode = mode;
+}
+
+_Midi::Thru _Midi::getThru() const {
+	return static_cast<Thru>(thruMode);
+}
+
+void _Midi::listenSysEx(uint8_t id) {
+	sysExId = id;
+}
+
+bool _Midi::thruIdle() const {
+	return !thruPending;
+}
+
+void _Midi::restateRunningStatus() {
+	thruRestate = true;
+}
+#endif
+
+#if MIDI_TRANSMIT
+void _Midi::send(uint8_t data) {
+	if (txHead == txTail && MidiSerial.writable()) {
+		MidiSerial.write(data);
+		return;
+	}
+
+	uint8_t next = (txHead + 1) & (txBufferSize - 1);
+
+	// THRU cannot produce more than we receive, so the buffer only
+	// fills if loop() stalls; drop rather than block then. Bulk senders
+	// check canSend() first.
+	if (next != txTail) {
+		txBuffer[txHead] = data;
+		txHead = next;
+	}
+
+	transmit();
+}
+
+bool _Midi::canSend(uint8_t count) const {
+	return ((txTail - txHead - 1) & (txBufferSize - 1)) >= count;
+}
+
+bool _Midi::transmitPending() const {
+	return txHead != txTail;
+}
+
+void _Midi::transmit() {
+	while (txHead != txTail && MidiSerial.writable()) {
+		MidiSerial.write(txBuffer[txTail]);
+		txTail = (txTail + 1) & (txBufferSize - 1);
+	}
+}
+#endif
+
+#if MIDI_HIGH_RESOLUTION
+struct Controllers {
+	enum {
+		DataEntryMsb       = 6,
+		LsbOffset          = 32,
+		DataEntryLsb       = 38,
+		NonPairedFirst     = 64,
+		DataIncrement      = 96,
+		DataDecrement      = 97,
+		NrpnLsb            = 98,
+		NrpnMsb            = 99,
+		RpnLsb             = 100,
+		RpnMsb             = 101,
+		ResetAll           = 121,
+	};
+};
+
+void _Midi::deliverParameter() {
+	Handlers::ControllerCallbackPtr handler = parameterIsNrpn
+		? handlers.nonRegisteredParameter
+		: handlers.registeredParameter;
+
+	if (handler && !(parameterMsb == 0x7F && parameterLsb == 0x7F)) {
+		handler(parameterChannel, parameterMsb << 7 | parameterLsb, parameterValue);
+	}
+}
+
+// Returns true if the message was consumed. State is a handful of
+// bytes shared by all channels, a controller pair or parameter
+// selection is dropped if another channel interleaves.
+bool _Midi::highResolutionController(uint8_t channel) {
+	uint8_t controller = dataBuffer[0];
+	uint8_t value = dataBuffer[1];
+	bool parameters = handlers.registeredParameter || handlers.nonRegisteredParameter;
+
+	if (parameters) {
+		switch (controller) {
+			case Controllers::NrpnLsb:
+			case Controllers::NrpnMsb:
+			case Controllers::RpnLsb:
+			case Controllers::RpnMsb:
+				if (controller & 1) {
+					parameterMsb = value;
+				} else {
+					parameterLsb = value;
+				}
+				parameterIsNrpn = controller < Controllers::RpnLsb;
+				parameterChannel = channel;
+				return true;
+
+			case Controllers::DataEntryMsb:
+			case Controllers::DataEntryLsb:
+			case Controllers::DataIncrement:
+			case Controllers::DataDecrement:
+				if (channel != parameterChannel) {
+					return true;
+				}
+				if (controller == Controllers::DataEntryMsb) {
+					parameterValue = value << 7;
+				} else if (controller == Controllers::DataEntryLsb) {
+					parameterValue = (parameterValue & 0x3F80) | value;
+				} else if (controller == Controllers::DataIncrement) {
+					if (parameterValue < 0x3FFF) parameterValue++;
+				} else if (parameterValue) {
+					parameterValue--;
+				}
+				deliverParameter();
+				return true;
+		}
+	}
+
+	if (controller == Controllers::ResetAll) {
+		pairController = 0xFF;
+		parameterMsb = parameterLsb = 0x7F;
+		return false;
+	}
+
+	if (!handlers.controlChange14 || controller >= Controllers::NonPairedFirst) {
+		return false;
+	}
+
+	if (controller < Controllers::LsbOffset) {
+		pairController = controller;
+		pairChannel = channel;
+		pairMsb = value;
+		handlers.controlChange14(channel, controller, value << 7);
+	} else if (controller - Controllers::LsbOffset == pairController && channel == pairChannel) {
+		handlers.controlChange14(channel, pairController, pairMsb << 7 | value);
+	}
+
+	// LSB without MSB is meaningless, swallow it
+	return true;
 }
+#endif
 
-_Midi::Handlers::CallbackPtr _Midi::getControlChangeHandler() {
+_Midi::Handlers::CallbackPtr _Midi::getControlChangeHandler(uint8_t channel) {
 	Handlers::CallbackPtr handler = nullptr;
+#if MIDI_HIGH_RESOLUTION
+	if (highResolutionController(channel)) {
+		return handler;
+	}
+#endif
 	// first data byte has controller number
 #if MIDI_CHANNEL_MODE
 	switch (dataBuffer[0]) {
@@ -78,22 +299,17 @@ _Midi::Handlers::CallbackPtr _Midi::getControlChangeHandler() {
 	return handler;
 }
 
-void _Midi::messageHandler(uint8_t status) {
-	// Remember that channel is only valid for Channel Voice Messages
+void _Midi::messageHandler(uint8_t status, uint16_t time) {
+	// Remember that channel is only valid for Channel Voice Messages,
+	// eventHandler() has already dropped the ones not meant for us
 	uint8_t statusChannel = channelFromStatus(status);
-	// ...so check if this is a Channel Voice etc message and this
-	// is our channel, or return
-	if (channel && status < 0xF0 && channel != statusChannel) {
-		return;
-	}
-
 	Handlers::CallbackPtr handler = nullptr;
 
 	switch (denseIndexFromStatus(status)) {
 		case denseIndexFromStatus(Messages::NoteOff):               handler = handlers.noteOff;               break;
 		case denseIndexFromStatus(Messages::NoteOn):                handler = handlers.noteOn;                break;
 		case denseIndexFromStatus(Messages::PolyphonicKeyPressure): handler = handlers.polyphonicKeyPressure; break;
-		case denseIndexFromStatus(Messages::ControlChange):         handler = getControlChangeHandler();      break;
+		case denseIndexFromStatus(Messages::ControlChange):         handler = getControlChangeHandler(statusChannel); break;
 		case denseIndexFromStatus(Messages::ProgramChange):         handler = handlers.programChange;         break;
 		case denseIndexFromStatus(Messages::ChannelPressure):       handler = handlers.channelPressure;       break;
 		case denseIndexFromStatus(Messages::PitchWheelChange):      handler = handlers.pitchWheelChange;      break;
@@ -126,6 +342,7 @@ void _Midi::messageHandler(uint8_t status) {
 			status,
 			statusChannel,
 			{ dataBuffer[0], dataBuffer[1], dataBuffer[2] },
+			time,
 		};
 
 		handler(message);
@@ -141,21 +358,173 @@ static const uint8_t bytes_to_read_lookup[23] PROGMEM = {
 	0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-void _Midi::eventHandler(uint8_t data) {
-	if (data & 0x80) {
-		currentMessage = data;
-		bytesToRead = pgm_read_byte(&bytes_to_read_lookup[denseIndexFromStatus(data)]);
-	} else if (dataBufferPosition < dataBufferSize) {
-		// store data
-		dataBuffer[dataBufferPosition++] = data;
-		bytesToRead--;
+#if MIDI_THRU
+// Other than real time
+void _Midi::forwardStatus(uint8_t status) {
+	if (status == 0xF0) {
+		thruPending = 0xFF;
+		thruStatus = 0;
+	} else {
+		thruPending = pgm_read_byte(&bytes_to_read_lookup[denseIndexFromStatus(status)]);
+		// System Common messages cancel running status
+		thruStatus = status < 0xF0 ? status : 0;
+		thruLength = thruPending;
+	}
+
+	thruRestate = false;
+	send(status);
+}
+
+void _Midi::forwardData(uint8_t data) {
+	if (!thruPending && thruStatus) {
+		// Running status, a new message
+		if (thruRestate) {
+			thruRestate = false;
+			send(thruStatus);
+		}
+		thruPending = thruLength;
+	}
+
+	if (thruPending && thruPending != 0xFF) {
+		thruPending--;
+	}
+
+	send(data);
+}
+#endif
+
+void _Midi::eventHandler(uint8_t data, uint16_t time) {
+#if MIDI_SYSTEM_COMMON
+	// Any status byte but EOX and real-time cuts SysEx short
+	if (currentMessage == Messages::SystemExclusive && !bytesToRead && (data & 0x80)
+			&& data < 0xF8 && data != Messages::EndOfExclusive) {
+		currentMessage = 0;
+		if (handlers.systemExclusiveAbort) {
+			handlers.systemExclusiveAbort(data);
+		}
 	}
+#endif
+	if (!(data & 0x80)) {
+#if MIDI_THRU
+		// Once turned off, only the message under way is finished
+		if (thruData && (thruMode != ThruOff || thruPending)) {
+			forwardData(data);
+		} else if (thruSysExPending && thruMode == ThruForeign) {
+			// Manufacturer ID, pass on SysEx that is not ours
+			thruSysExPending = false;
+			thruData = data != sysExId;
+			if (thruData) {
+				forwardStatus(0xF0);
+				forwardData(data);
+			}
+		}
+#endif
+		// Data byte of a message not meant for us, or stray data
+		if (!currentMessage) {
+			return;
+		}
+
+#if MIDI_SYSTEM_COMMON
+		if (currentMessage == Messages::SystemExclusive && !bytesToRead) {
+			if (handlers.systemExclusiveData) {
+				handlers.systemExclusiveData(data);
+			}
+			return;
+		}
+#endif
+#if MIDI_TIMESTAMP
+		if (stampNext) {
+			messageTime = time;
+			stampNext = false;
+		}
+#endif
+		dataBuffer[dataBufferPosition++] = data;
 
-	// ... until
-	if (bytesToRead == 0) {
-		// ... message buffer full, handle message
-		messageHandler(currentMessage);
-		// Reset data buffer
+		if (--bytesToRead) {
+			return;
+		}
+	} else if (data >= 0xF8) {
+		// Real-time messages may appear anywhere, even between data
+		// bytes, and do not affect running status
+#if MIDI_THRU
+		if (thruMode != ThruOff) {
+			send(data);
+		}
+#endif
+#if MIDI_TIMESTAMP
+		messageHandler(data, time);
+#else
+		messageHandler(data, 0);
+#endif
+		return;
+	} else if (data < 0xF0 && !(channels & channelBitFromStatus(data))) {
+		// Channel Voice etc message for someone else, skip data bytes
+		// until next status byte
+#if MIDI_THRU
+		thruData = thruMode != ThruOff;
+		thruSysExPending = false;
+		if (thruData) {
+			forwardStatus(data);
+		} else {
+			// Anything forwarded before ends here
+			thruPending = 0;
+		}
+#endif
+		currentMessage = 0;
+		return;
+	} else {
+#if MIDI_THRU
+		// Ours, System Common messages are passed on in both modes.
+		// SysEx waits for its ID in ThruForeign mode, and its end goes
+		// where the rest of it went, even if THRU was turned off since.
+		if (data == 0xF7 && currentMessage == 0xF0) {
+			// thruData as for the SysEx
+		} else if (thruMode == ThruForeign) {
+			thruData = data > 0xF0;
+		} else {
+			thruData = thruMode == ThruAll;
+		}
+		thruSysExPending = thruMode == ThruForeign && data == 0xF0;
+		if (thruData) {
+			forwardStatus(data);
+		} else {
+			thruPending = 0;
+		}
+#endif
+		currentMessage = data;
+#if MIDI_TIMESTAMP
+		messageTime = time;
+		stampNext = false;
+#endif
+		messageLength = pgm_read_byte(&bytes_to_read_lookup[denseIndexFromStatus(data)]);
+		bytesToRead = messageLength;
 		dataBufferPosition = 0;
+
+		if (bytesToRead) {
+			return;
+		}
+	}
+
+	// ... message complete, handle it
+#if MIDI_TIMESTAMP
+	messageHandler(currentMessage, messageTime);
+#else
+	messageHandler(currentMessage, 0);
+#endif
+	dataBufferPosition = 0;
+
+	if (currentMessage < 0xF0) {
+		// Running status, following data bytes form a new message
+		bytesToRead = messageLength;
+#if MIDI_TIMESTAMP
+		stampNext = true;
+#endif
+#if MIDI_SYSTEM_COMMON
+	} else if (currentMessage == Messages::SystemExclusive) {
+		// Manufacturer ID handled, stream the rest until a status byte
+#endif
+	} else {
+		// System Common messages cancel running status
+		currentMessage = 0;
 	}
 }
@@ -0,0 +1,35 @@
+// Auduino runtime, startup without the Arduino core
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+// 17 Oct 2026: serialEventRun() is optional, as in the core
+//
+// Linked instead of libcore.a in bare metal builds (make BAREMETAL=1).
+// Unlike the core's init() nothing but our own peripherals is set up:
+// Timer0 and its millis() interrupt, Timer1 and the ADC stay off, so
+// the audio interrupt is the only periodic one.
+
+#include <avr/interrupt.h>
+
+extern void setup();
+extern void loop();
+// midi.cpp drains the receive buffer here unless MIDI_HOOK_SERIAL_EVENT
+// is off
+extern void serialEventRun() __attribute__((weak));
+
+int main() {
+  setup();
+  sei();
+
+  for (;;) {
+    loop();
+
+    if (serialEventRun) {
+      serialEventRun();
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,32 @@
+// Auduino Scale, quantising pots and controllers to a runtime scale
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+
+#include "scale.h"
+
+// The Instance
+_Scale Scale;
+
+void _Scale::set(uint16_t mask_, uint8_t root_) {
+  mask = mask_ & SCALE_CHROMATIC;
+  root = root_ % 12;
+
+  uint16_t bits = mask ? mask : static_cast<uint16_t>(SCALE_CHROMATIC);
+  // degree of note 0 above the root
+  uint8_t degree = root ? 12 - root : 0;
+
+  count = 0;
+
+  for (uint8_t n = 0; n < 128; n++) {
+    if (bits & (1 << degree)) {
+      notes[count++] = n;
+    }
+
+    if (++degree == 12) {
+      degree = 0;
+    }
+  }
+}
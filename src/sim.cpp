@@ -0,0 +1,72 @@
+// Auduino simulator harness, MIDI feed and sample capture for simulavr
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version as the jitter bench
+// 17 Oct 2026: Bridge mode, MIDI from DEBUGPIN, free running Timer1
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "midi.h"
+#include "debug.h"
+#include "sim.h"
+
+static const uint16_t byteCycles = F_CPU * 10 / MIDI_BAUD_RATE;
+
+static_assert(F_CPU * 10 / MIDI_BAUD_RATE <= 0xFFFF,
+	"MIDI_BAUD_RATE too low for Timer1");
+
+#if AUDUINO_BRIDGE
+static volatile uint8_t *_pin = reinterpret_cast<volatile uint8_t *>(DEBUGPIN);
+
+// Stands in for the receive interrupt, one byte time per read
+ISR(TIMER1_COMPA_vect) {
+	OCR1A += byteCycles;
+
+	uint8_t data = *_pin;
+
+	if (data != SIM_IDLE) {
+		MidiSerial.push(data);
+	}
+}
+#else
+// Notes, running status, controllers, pitch bend and clock: every path
+// loop() takes for channel data. No Reset or Active Sensing.
+static const uint8_t flood[] PROGMEM = {
+	0x90, 60, 100, 64, 90, 67, 80,
+	0xB0, 1, 64, 33, 10,
+	0xE0, 0, 64, 0x7F, 0x7F,
+	0xF8,
+	0x80, 60, 0, 64, 0, 67, 0,
+	0xB0, 1, 0,
+	0xE0, 0, 0x40,
+	0xF8,
+};
+
+static uint8_t floodPosition;
+
+// Stands in for the receive interrupt, the flood never pauses
+ISR(TIMER1_COMPA_vect) {
+	OCR1A += byteCycles;
+	MidiSerial.push(pgm_read_byte(&flood[floodPosition]));
+
+	if (++floodPosition == sizeof(flood)) {
+		floodPosition = 0;
+	}
+}
+#endif
+
+// Timer1 runs free at F_CPU, as for the trace stamps, and the compare
+// match moves one MIDI byte time ahead on every interrupt
+void setup_sim_feed() {
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+	OCR1A = TCNT1 + byteCycles;
+#if defined(TIMSK1)
+	TIMSK1 = _BV(OCIE1A);
+#else
+	TIMSK |= _BV(OCIE1A);
+#endif
+}
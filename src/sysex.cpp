@@ -0,0 +1,293 @@
+// Auduino SysEx dump, bulk save and restore of device state
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+// 17 Oct 2026: SysEx receive left to the sketch, shared with tuning
+// 17 Oct 2026: Status messages
+// 17 Oct 2026: sending()
+// 17 Oct 2026: Own messages only between forwarded ones
+// 17 Oct 2026: receiveAbort()
+
+#include <avr/pgmspace.h>
+#include "midi.h"
+#include "sysex.h"
+
+#if SYSEX_DUMP
+
+#if !MIDI_TRANSMIT || !MIDI_SYSTEM_COMMON
+# error "SYSEX_DUMP needs MIDI_TRANSMIT and MIDI_SYSTEM_COMMON"
+#endif
+
+// The Instance
+_SysExDump SysExDump;
+
+void _SysExDump::begin(const SysExRegion *regions_, uint8_t regionCount_) {
+	regions = regions_;
+	regionCount = regionCount_;
+	rxPhase = Ignore;
+	rxRequest = false;
+	txPhase = Idle;
+}
+
+// Walks the regions a byte at a time, nullptr at the end
+uint8_t *_SysExDump::next(Cursor &cursor) {
+	while (cursor.region < regionCount) {
+		SysExRegion region;
+		memcpy_P(&region, &regions[cursor.region], sizeof(region));
+
+		if (cursor.item < region.count) {
+			uint8_t *data = static_cast<uint8_t *>(region.data)
+				+ cursor.item * region.stride
+				+ cursor.offset;
+
+			if (++cursor.offset == region.size) {
+				cursor.offset = 0;
+				cursor.item++;
+			}
+
+			return data;
+		}
+
+		cursor.region++;
+		cursor.item = 0;
+	}
+
+	return nullptr;
+}
+
+uint8_t _SysExDump::descriptorByte(uint16_t index) {
+	SysExRegion region;
+	memcpy_P(&region, &regions[index >> 2], sizeof(region));
+
+	switch (index & 3) {
+		case 0:  return region.id;
+		case 1:  return region.size & 0x7F;
+		case 2:  return region.size >> 7;
+		default: return region.count;
+	}
+}
+
+void _SysExDump::receiveStart(uint8_t id) {
+	rxPhase = id == manufacturerId ? Model : Ignore;
+	rxRequest = false;
+}
+
+void _SysExDump::receive(uint8_t data) {
+	switch (rxPhase) {
+		case Model:
+			rxPhase = data == modelId ? Command : Ignore;
+			break;
+
+		case Command:
+			if (data == DumpRequest) {
+				rxRequest = true;
+				rxPhase = End;
+			} else if (data == Dump) {
+				rxPhase = Version;
+			} else {
+				rxPhase = Ignore;
+			}
+			break;
+
+		case Version:
+			rxPhase = data == version ? RegionCount : Ignore;
+			break;
+
+		case RegionCount:
+			rxPhase = data == regionCount ? Descriptors : Ignore;
+			rxIndex = 0;
+			break;
+
+		case Descriptors:
+			// Refuse dumps of another layout before touching anything
+			if (data != descriptorByte(rxIndex)) {
+				rxPhase = Ignore;
+			} else if (++rxIndex == regionCount * 4U) {
+				rxPhase = Data;
+				rxCursor = Cursor();
+				rxGroupPosition = 0;
+				rxSum = 0;
+			}
+			break;
+
+		case Data:
+			rxSum += data;
+
+			if (!rxGroupPosition) {
+				rxGroupMsbs = data;
+				rxGroupPosition = 1;
+			} else {
+				// Checksum lands here too, after the last region
+				uint8_t *byte = next(rxCursor);
+
+				if (byte) {
+					*byte = data | ((rxGroupMsbs >> (rxGroupPosition - 1)) & 1) << 7;
+				}
+
+				if (++rxGroupPosition == 8) {
+					rxGroupPosition = 0;
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+void _SysExDump::receiveEnd() {
+	if (rxPhase == Data) {
+		bool ok = !next(rxCursor) && !(rxSum & 0x7F);
+
+		if (loaded) {
+			loaded(ok);
+		}
+	} else if (rxPhase == End && rxRequest) {
+		send();
+	}
+
+	rxPhase = Ignore;
+	rxRequest = false;
+}
+
+void _SysExDump::receiveAbort() {
+	if (rxPhase == Data && loaded) {
+		loaded(false);
+	}
+
+	rxPhase = Ignore;
+	rxRequest = false;
+}
+
+void _SysExDump::send() {
+	if (txPhase != Idle) {
+		return;
+	}
+
+	txPhase = Header;
+	txIndex = 0;
+#if MIDI_THRU
+	// Forwarded bytes would end up inside our SysEx
+	txThru = Midi.getThru();
+	Midi.thru(_Midi::ThruOff);
+#endif
+}
+
+bool _SysExDump::sending() const {
+	return txPhase != Idle;
+}
+
+// Queued in one go, nothing gets between the bytes
+bool _SysExDump::sendStatus(const uint8_t *data, uint8_t length) {
+	if (txPhase != Idle || !Midi.canSend(length + 5)) {
+		return false;
+	}
+#if MIDI_THRU
+	if (!Midi.thruIdle()) {
+		return false;
+	}
+#endif
+
+	Midi.send(0xF0);
+	Midi.send(manufacturerId);
+	Midi.send(modelId);
+	Midi.send(Status);
+
+	for (uint8_t i = 0; i < length; i++) {
+		Midi.send(data[i] & 0x7F);
+	}
+
+	Midi.send(0xF7);
+#if MIDI_THRU
+	Midi.restateRunningStatus();
+#endif
+	return true;
+}
+
+static const uint8_t dump_header[] PROGMEM = {
+	0xF0,
+	_SysExDump::manufacturerId,
+	_SysExDump::modelId,
+	_SysExDump::Dump,
+	_SysExDump::version,
+};
+
+// -1 when there is nothing to send
+int16_t _SysExDump::nextByte() {
+	switch (txPhase) {
+		case Header:
+			if (txIndex < sizeof(dump_header)) {
+				return pgm_read_byte(&dump_header[txIndex++]);
+			}
+			txPhase = Descriptors;
+			txIndex = 0;
+			return regionCount;
+
+		case Descriptors:
+			if (txIndex < regionCount * 4U) {
+				return descriptorByte(txIndex++);
+			}
+			txPhase = Data;
+			txCursor = Cursor();
+			txGroupLength = txGroupPosition = 0;
+			txSum = 0;
+			// fall through
+
+		case Data:
+			if (txGroupPosition == txGroupLength) {
+				uint8_t msbs = 0;
+
+				for (txGroupLength = 0; txGroupLength < sizeof(txGroup); txGroupLength++) {
+					uint8_t *byte = next(txCursor);
+
+					if (!byte) {
+						break;
+					}
+
+					txGroup[txGroupLength] = *byte;
+					msbs |= (*byte >> 7) << txGroupLength;
+				}
+
+				txGroupPosition = 0;
+
+				if (!txGroupLength) {
+					txPhase = End;
+					return -txSum & 0x7F;
+				}
+
+				txSum += msbs;
+				return msbs;
+			} else {
+				uint8_t data = txGroup[txGroupPosition++] & 0x7F;
+				txSum += data;
+				return data;
+			}
+
+		case End:
+			txPhase = Idle;
+#if MIDI_THRU
+			Midi.restateRunningStatus();
+			Midi.thru(static_cast<_Midi::Thru>(txThru));
+#endif
+			return 0xF7;
+
+		default:
+			return -1;
+	}
+}
+
+void _SysExDump::poll() {
+#if MIDI_THRU
+	// THRU is off, start once the message it was forwarding is done
+	if (txPhase == Header && !txIndex && !Midi.thruIdle()) {
+		return;
+	}
+#endif
+	while (txPhase != Idle && Midi.canSend()) {
+		Midi.send(nextByte());
+	}
+}
+
+#endif
@@ -0,0 +1,230 @@
+// Auduino Tuning, MIDI notes to phase increments
+//
+// by Peter Knight, Tinker.it http://tinker.it,
+//    Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Split from auduino.cpp, add RAM table loaded with MIDI
+//              Tuning Standard messages and kept in EEPROM
+// 17 Oct 2026: Trace tuning changes
+// 17 Oct 2026: revert()
+// 17 Oct 2026: Any unfinished change undone at receiveEnd()
+
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+#include <math.h>
+#include "tuning.h"
+#include "debug.h"
+
+// The Instance
+_Tuning Tuning;
+
+constexpr double midiNoteToFreq(double p) {
+  return pow(2.0, (p - 69) / 12.0) * 440.0;
+}
+
+constexpr uint16_t freqToInc(double f, double accSteps, double sr) {
+  // with rounding
+  return f * accSteps / sr + 0.5;
+}
+
+#define MIDI_TO_INC(p) freqToInc(midiNoteToFreq(p), 65536, 31250)
+
+// Stepped chromatic mapping
+//
+const uint16_t midiTable[128] PROGMEM = {
+  MIDI_TO_INC(0), MIDI_TO_INC(1), MIDI_TO_INC(2), MIDI_TO_INC(3), MIDI_TO_INC(4), MIDI_TO_INC(5), MIDI_TO_INC(6), MIDI_TO_INC(7),
+  MIDI_TO_INC(8), MIDI_TO_INC(9), MIDI_TO_INC(10), MIDI_TO_INC(11), MIDI_TO_INC(12), MIDI_TO_INC(13), MIDI_TO_INC(14), MIDI_TO_INC(15),
+  MIDI_TO_INC(16), MIDI_TO_INC(17), MIDI_TO_INC(18), MIDI_TO_INC(19), MIDI_TO_INC(20), MIDI_TO_INC(21), MIDI_TO_INC(22), MIDI_TO_INC(23),
+  MIDI_TO_INC(24), MIDI_TO_INC(25), MIDI_TO_INC(26), MIDI_TO_INC(27), MIDI_TO_INC(28), MIDI_TO_INC(29), MIDI_TO_INC(30), MIDI_TO_INC(31),
+  MIDI_TO_INC(32), MIDI_TO_INC(33), MIDI_TO_INC(34), MIDI_TO_INC(35), MIDI_TO_INC(36), MIDI_TO_INC(37), MIDI_TO_INC(38), MIDI_TO_INC(39),
+  MIDI_TO_INC(40), MIDI_TO_INC(41), MIDI_TO_INC(42), MIDI_TO_INC(43), MIDI_TO_INC(44), MIDI_TO_INC(45), MIDI_TO_INC(46), MIDI_TO_INC(47),
+  MIDI_TO_INC(48), MIDI_TO_INC(49), MIDI_TO_INC(50), MIDI_TO_INC(51), MIDI_TO_INC(52), MIDI_TO_INC(53), MIDI_TO_INC(54), MIDI_TO_INC(55),
+  MIDI_TO_INC(56), MIDI_TO_INC(57), MIDI_TO_INC(58), MIDI_TO_INC(59), MIDI_TO_INC(60), MIDI_TO_INC(61), MIDI_TO_INC(62), MIDI_TO_INC(63),
+  MIDI_TO_INC(64), MIDI_TO_INC(65), MIDI_TO_INC(66), MIDI_TO_INC(67), MIDI_TO_INC(68), MIDI_TO_INC(69), MIDI_TO_INC(70), MIDI_TO_INC(71),
+  MIDI_TO_INC(72), MIDI_TO_INC(73), MIDI_TO_INC(74), MIDI_TO_INC(75), MIDI_TO_INC(76), MIDI_TO_INC(77), MIDI_TO_INC(78), MIDI_TO_INC(79),
+  MIDI_TO_INC(80), MIDI_TO_INC(81), MIDI_TO_INC(82), MIDI_TO_INC(83), MIDI_TO_INC(84), MIDI_TO_INC(85), MIDI_TO_INC(86), MIDI_TO_INC(87),
+  MIDI_TO_INC(88), MIDI_TO_INC(89), MIDI_TO_INC(90), MIDI_TO_INC(91), MIDI_TO_INC(92), MIDI_TO_INC(93), MIDI_TO_INC(94), MIDI_TO_INC(95),
+  MIDI_TO_INC(96), MIDI_TO_INC(97), MIDI_TO_INC(98), MIDI_TO_INC(99), MIDI_TO_INC(100), MIDI_TO_INC(101), MIDI_TO_INC(102), MIDI_TO_INC(103),
+  MIDI_TO_INC(104), MIDI_TO_INC(105), MIDI_TO_INC(106), MIDI_TO_INC(107), MIDI_TO_INC(108), MIDI_TO_INC(109), MIDI_TO_INC(110), MIDI_TO_INC(111),
+  MIDI_TO_INC(112), MIDI_TO_INC(113), MIDI_TO_INC(114), MIDI_TO_INC(115), MIDI_TO_INC(116), MIDI_TO_INC(117), MIDI_TO_INC(118), MIDI_TO_INC(119),
+  MIDI_TO_INC(120), MIDI_TO_INC(121), MIDI_TO_INC(122), MIDI_TO_INC(123), MIDI_TO_INC(124), MIDI_TO_INC(125), MIDI_TO_INC(126), MIDI_TO_INC(127),
+};
+
+#if TUNING_TABLE
+
+#define TUNING_MAGIC 0x4d54
+
+static struct {
+  uint16_t table[128];
+  uint16_t magic;
+} stored EEMEM;
+
+void _Tuning::begin() {
+  phase = Ignore;
+  persistIndex = persistDone;
+  load();
+}
+
+void _Tuning::load() {
+  if (eeprom_read_word(&stored.magic) == TUNING_MAGIC) {
+    eeprom_read_block(table, stored.table, sizeof(table));
+  } else {
+    memcpy_P(table, midiTable, sizeof(table));
+  }
+}
+
+// MTS frequency: semitone and 14bit fraction of a semitone up from it
+uint16_t _Tuning::frequencyToInc(uint8_t semitone, uint16_t fraction) {
+  uint16_t inc = pgm_read_word(&midiTable[semitone]);
+  // 2^(1/12) - 1 = 3897 / 65536 for the semitone above note 127
+  uint16_t next = semitone < 127
+    ? pgm_read_word(&midiTable[semitone + 1])
+    : inc + (static_cast<uint32_t>(inc) * 3897 >> 16);
+
+  return inc + (static_cast<uint32_t>(next - inc) * fraction >> 14);
+}
+
+void _Tuning::retune(uint8_t note) {
+  // 7F 7F 7F means no change
+  if (note < 128 && !(data[0] == 0x7f && data[1] == 0x7f && data[2] == 0x7f)) {
+    table[note] = frequencyToInc(data[0], data[1] << 7 | data[2]);
+  }
+}
+
+// F0 7E dd 08 01 pp [16 byte name] [128 x xx yy zz] cs F7
+//                                   bulk dump, cs XOR of 7E to last data
+// F0 7F dd 08 02 pp ll [ll x kk xx yy zz] F7
+//                                   single note tuning change
+void _Tuning::receiveStart(uint8_t id) {
+  bulk = id == 0x7e;
+  phase = bulk || id == 0x7f ? Device : Ignore;
+  checksum = id;
+}
+
+void _Tuning::receive(uint8_t byte) {
+  checksum ^= byte;
+
+  switch (phase) {
+    case Device:
+      // any device ID, we do not have one
+      phase = SubId1;
+      break;
+
+    case SubId1:
+      phase = byte == 0x08 ? SubId2 : Ignore;
+      break;
+
+    case SubId2:
+      phase = (bulk && byte == 0x01) || (!bulk && byte == 0x02) ? Program : Ignore;
+      break;
+
+    case Program:
+      // single program only
+      phase = bulk ? Name : NoteCount;
+      index = 0;
+      break;
+
+    case Name:
+      if (++index == 16) {
+        phase = BulkData;
+        index = 0;
+        position = 0;
+      }
+      break;
+
+    case BulkData:
+      data[position++] = byte;
+
+      if (position == 3) {
+        retune(index);
+        position = 0;
+
+        if (++index == 128) {
+          phase = Checksum;
+        }
+      }
+      break;
+
+    case Checksum:
+      // checksum ^ byte == 0 if they match
+      if (checksum) {
+        // Corrupt, back to what we had
+        load();
+      } else {
+        changed();
+        TRACE(TRACE_TUNING, 1);
+      }
+      phase = End;
+      break;
+
+    case NoteCount:
+      index = byte;
+      position = 0;
+      phase = index ? NoteData : End;
+      break;
+
+    case NoteData:
+      if (!position) {
+        note = byte;
+      } else {
+        data[position - 1] = byte;
+      }
+
+      if (++position == 4) {
+        retune(note);
+        position = 0;
+
+        if (!--index) {
+          changed();
+          TRACE(TRACE_TUNING, 2);
+          phase = End;
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void _Tuning::receiveEnd() {
+  // Cut short, notes retuned so far are taken back
+  if (phase != End && phase != Ignore) {
+    load();
+  }
+
+  phase = Ignore;
+}
+
+void _Tuning::changed() {
+  persistIndex = 0;
+}
+
+void _Tuning::revert() {
+  load();
+}
+
+// eeprom_update_byte() skips bytes that did not change, a retune of a
+// few notes costs a few writes
+void _Tuning::poll() {
+  if (persistIndex == persistDone || !eeprom_is_ready()) {
+    return;
+  }
+
+  if (persistIndex < sizeof(table)) {
+    eeprom_update_byte(reinterpret_cast<uint8_t *>(stored.table) + persistIndex,
+      reinterpret_cast<uint8_t *>(table)[persistIndex]);
+    persistIndex++;
+  } else {
+    eeprom_update_word(&stored.magic, TUNING_MAGIC);
+    persistIndex = persistDone;
+  }
+}
+
+#else
+
+void _Tuning::begin() {
+}
+
+#endif
@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+# Auduino simulator bridge, Standard MIDI File in, WAV and trace out.
+# See include/sim.h for the firmware side.
+#
+# by Ilja Everilä <saarni@gmail.com>
+#
+# ChangeLog:
+# 17 Oct 2026: Initial version
+# 17 Oct 2026: flood
+#
+# Usage:
+#   bridge.py stream song.mid song.stream [--baud 31250]
+#   bridge.py flood flood.stream [--baud 31250] [--seconds 2]
+#   bridge.py wav song.raw song.wav [--cpufrequency 16000000]
+#   bridge.py run song.mid song.wav song.log --firmware auduino.elf ...
+#
+# A stream has one byte per MIDI byte time, 10 bits at the baud rate,
+# SIM_IDLE (0xFD) where the wire is idle. A flood stream has no idle
+# slot at all. The firmware reads one byte
+# per byte time from DEBUGPIN, so the events keep their SMF timing to
+# within one byte. Bytes that would collide slide to the next free
+# slot, as they would on a real wire.
+#
+# The firmware writes every sample to SIM_PORT, 8bit unsigned at the
+# phase correct PWM rate F_CPU / 510.
+
+import argparse
+import contextlib
+import importlib.util
+import os
+import struct
+import subprocess
+import sys
+import wave
+
+IDLE = 0xFD
+# Time after the last event for release tails
+TAIL = 2.0
+# Setup runs before the first byte is read
+LEAD = 0.05
+# Channel data of every kind loop() parses, as the jitter bench flood
+# in src/sim.cpp
+FLOOD = bytes([
+    0x90, 60, 100, 64, 90, 67, 80,
+    0xB0, 1, 64, 33, 10,
+    0xE0, 0, 64, 0x7F, 0x7F,
+    0xF8,
+    0x80, 60, 0, 64, 0, 67, 0,
+    0xB0, 1, 0,
+    0xE0, 0, 0x40,
+    0xF8,
+])
+
+
+def read_vlq(data, pos):
+    value = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value = value << 7 | byte & 0x7F
+        if not byte & 0x80:
+            return value, pos
+
+
+def read_track(data):
+    """Yields (tick, kind, payload), kind is 'midi' or 'tempo'."""
+    pos = 0
+    tick = 0
+    status = 0
+    while pos < len(data):
+        delta, pos = read_vlq(data, pos)
+        tick += delta
+        byte = data[pos]
+        if byte == 0xFF:
+            kind = data[pos + 1]
+            length, pos = read_vlq(data, pos + 2)
+            if kind == 0x51:
+                yield tick, "tempo", int.from_bytes(data[pos:pos + 3], "big")
+            elif kind == 0x2F:
+                return
+            pos += length
+        elif byte in (0xF0, 0xF7):
+            length, pos = read_vlq(data, pos + 1)
+            body = data[pos:pos + length]
+            pos += length
+            # F7 escapes carry raw bytes, F0 omits its own status
+            yield tick, "midi", (bytes([0xF0]) if byte == 0xF0 else b"") + body
+            status = 0
+        else:
+            if byte & 0x80:
+                status = byte
+                pos += 1
+            elif not status:
+                raise ValueError("data byte without status at %d" % pos)
+            length = 1 if status & 0xE0 == 0xC0 else 2
+            yield tick, "midi", bytes([status]) + data[pos:pos + length]
+            pos += length
+
+
+def read_smf(path):
+    """Returns [(seconds, bytes)] in time order."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"MThd":
+        raise ValueError("%s is not a Standard MIDI File" % path)
+    length, fmt, ntracks, division = struct.unpack(">IHHH", data[4:14])
+    if fmt == 2:
+        raise ValueError("format 2 files are not supported")
+    if division & 0x8000:
+        raise ValueError("SMPTE time division is not supported")
+    pos = 8 + length
+    events = []
+    for number in range(ntracks):
+        kind, length = struct.unpack(">4sI", data[pos:pos + 8])
+        pos += 8
+        if kind == b"MTrk":
+            for tick, what, payload in read_track(data[pos:pos + length]):
+                events.append((tick, number, what, payload))
+        pos += length
+    # Stable within a track, tempo changes first on equal ticks
+    events.sort(key=lambda e: (e[0], e[2] != "tempo", e[1]))
+
+    timed = []
+    tempo = 500000
+    last_tick = 0
+    seconds = 0.0
+    for tick, _, what, payload in events:
+        seconds += (tick - last_tick) * tempo / 1e6 / division
+        last_tick = tick
+        if what == "tempo":
+            tempo = payload
+        else:
+            timed.append((seconds, payload))
+    return timed
+
+
+def stream(events, baud, lead=LEAD):
+    """Lays out events in byte slots, returns the stream."""
+    slot = 10.0 / baud
+    out = bytearray()
+    for seconds, payload in events:
+        start = int((seconds + lead) / slot)
+        if len(out) < start:
+            out.extend([IDLE] * (start - len(out)))
+        out.extend(payload)
+    return out
+
+
+def frequency(text):
+    # Makefile style 16000000L
+    return int(text.rstrip("UuLl"))
+
+
+def write_wav(samples, path, f_cpu):
+    with wave.open(path, "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(1)
+        w.setframerate(round(f_cpu / 510))
+        w.writeframes(bytes(samples))
+
+
+def load_trace():
+    # By path, the standard library has a module called trace
+    here = os.path.dirname(os.path.abspath(__file__))
+    spec = importlib.util.spec_from_file_location(
+        "auduino_trace", os.path.join(here, "trace.py"))
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def command_stream(args):
+    data = stream(read_smf(args.midi), args.baud)
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+
+def command_flood(args):
+    slots = int(args.seconds * args.baud / 10)
+    data = stream([(0, FLOOD * (slots // len(FLOOD) + 1))], args.baud)
+    with open(args.output, "wb") as f:
+        f.write(data[:int(LEAD * args.baud / 10) + slots])
+
+
+def command_wav(args):
+    with open(args.raw, "rb") as f:
+        write_wav(f.read(), args.output, args.cpufrequency)
+
+
+def command_run(args):
+    base = os.path.splitext(args.output)[0]
+    stream_path = base + ".stream"
+    raw_path = base + ".raw"
+    trace_path = base + ".trace"
+
+    data = stream(read_smf(args.midi), args.baud)
+    seconds = len(data) * 10.0 / args.baud + TAIL
+    # Reads past the end of the file must still see an idle wire
+    data.extend([IDLE] * (int(seconds * args.baud / 10) - len(data) + 1))
+    with open(stream_path, "wb") as f:
+        f.write(data)
+
+    subprocess.check_call([
+        args.simulator,
+        "--device", args.device,
+        "--file", args.firmware,
+        "--cpufrequency", str(args.cpufrequency),
+        "--readfrompipe", "%s,%s" % (args.debugpin, stream_path),
+        "--writetopipe", "%s,%s" % (args.simport, raw_path),
+        "--writetopipe", "%s,%s" % (args.debugport, trace_path),
+        "--maxruntime", str(int(seconds * 1e9)),
+    ])
+
+    with open(raw_path, "rb") as f:
+        write_wav(f.read(), args.output, args.cpufrequency)
+
+    trace = load_trace()
+    here = os.path.dirname(os.path.abspath(__file__))
+    ids = trace.read_ids(os.path.join(here, "..", "include", "trace.h"))
+    with open(trace_path, "rb") as f, open(args.log, "w") as log, \
+            contextlib.redirect_stdout(log):
+        trace.decode(f, ids, float(args.cpufrequency))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Auduino simulator bridge")
+    commands = parser.add_subparsers(dest="command")
+    commands.required = True
+
+    p = commands.add_parser("stream", help="SMF to a timed byte stream")
+    p.add_argument("midi")
+    p.add_argument("output")
+    p.add_argument("--baud", type=int, default=31250)
+    p.set_defaults(run=command_stream)
+
+    p = commands.add_parser("flood", help="MIDI at the full baud rate")
+    p.add_argument("output")
+    p.add_argument("--baud", type=int, default=31250)
+    p.add_argument("--seconds", type=float, default=2.0)
+    p.set_defaults(run=command_flood)
+
+    p = commands.add_parser("wav", help="captured samples to WAV")
+    p.add_argument("raw")
+    p.add_argument("output")
+    p.add_argument("--cpufrequency", type=frequency, default=16000000)
+    p.set_defaults(run=command_wav)
+
+    p = commands.add_parser("run", help="play an SMF in simulavr")
+    p.add_argument("midi")
+    p.add_argument("output", help="WAV file")
+    p.add_argument("log", help="decoded trace")
+    p.add_argument("--firmware", required=True)
+    p.add_argument("--simulator", default="simulavr")
+    p.add_argument("--device", default="atmega328")
+    p.add_argument("--cpufrequency", type=frequency, default=16000000)
+    p.add_argument("--baud", type=int, default=31250)
+    p.add_argument("--simport", default="0x21")
+    p.add_argument("--debugport", default="0x20")
+    p.add_argument("--debugpin", default="0x22")
+    p.set_defaults(run=command_run)
+
+    args = parser.parse_args(argv[1:])
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+# Auduino jitter bench report, see include/sim.h.
+#
+# by Ilja Everilä <saarni@gmail.com>
+#
+# ChangeLog:
+# 17 Oct 2026: Initial version
+# 17 Oct 2026: 16 bit stamps, late writes counted past TOP
+#
+# Usage:
+#   jitter.py jitter.log [F_CPU]
+#
+# Each 16 bit little endian word of the log is the cycles from the timer
+# overflow to one PWM write. The timer turns at TOP half a sample period
+# after the overflow, a write after that lands in the next period.
+
+import struct
+import sys
+
+# 8 bit phase correct PWM at F_CPU, up to TOP and back down
+SAMPLE_CYCLES = 510
+
+# Skip setup, Timer1 and the MIDI stream start after it
+WARMUP = 64
+
+
+def percentile(ordered, p):
+    return ordered[min(len(ordered) - 1, len(ordered) * p // 100)]
+
+
+def report(counts, f_cpu):
+    ordered = sorted(counts)
+    ns = 1e9 / f_cpu
+
+    print("samples %d" % len(ordered))
+    for name, value in (("min", ordered[0]),
+                        ("p50", percentile(ordered, 50)),
+                        ("p99", percentile(ordered, 99)),
+                        ("max", ordered[-1])):
+        print("%-4s %4d cycles %7.1f ns" % (name, value, value * ns))
+
+    spread = ordered[-1] - ordered[0]
+    print("jitter %d cycles %.1f ns" % (spread, spread * ns))
+
+    if ordered[-1] >= SAMPLE_CYCLES // 2:
+        print("warning: PWM write after TOP, samples were delayed")
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.exit("usage: jitter.py jitter.log [F_CPU]")
+
+    f_cpu = float(argv[2]) if len(argv) > 2 else 16e6
+
+    with open(argv[1], "rb") as f:
+        log = f.read()
+    words = struct.iter_unpack("<H", log[:len(log) & ~1])
+    counts = [c for (c,) in words][WARMUP:]
+
+    if not counts:
+        sys.exit("no samples in %s" % argv[1])
+
+    report(counts, f_cpu)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,268 @@
+// Auduino simavr harness, VCD of the audio, LED and MIDI pins
+//
+// by Ilja Everilä <saarni@gmail.com>
+//
+// ChangeLog:
+// 17 Oct 2026: Initial version
+// 17 Oct 2026: Debug port log for make rxcheck
+//
+// Usage:
+//   trace [-m mcu] [-f F_CPU] [-b baud] [-t tail] [-o vcd]
+//         [-d debug.log] [-p DEBUGPORT] auduino song.stream
+//
+// Runs the firmware in simavr and plays the timed byte stream of
+// tools/bridge.py into the MIDI USART, bit by bit on a virtual RX line
+// as well as byte by byte into simavr's receiver. The VCD has
+//
+//   pwm, pwm_value  output pin and the compare value behind it
+//   led             LED_PORT, toggled on grain retrigger
+//   rx, midi_in     RX line and each byte as it completes
+//   audio_isr       audio interrupt running, entry to reti
+//   rx_isr          USART receive interrupt running
+//
+// Pins and vectors are those of auduino.cpp for each MCU. With -d the
+// bytes a DEBUG=1 build writes to DEBUGPORT go to a file, the trace
+// records of include/trace.h for tools/trace.py.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_interrupts.h"
+#include "sim_cycle_timers.h"
+#include "sim_vcd_file.h"
+#include "avr_ioport.h"
+#include "avr_timer.h"
+#include "avr_uart.h"
+
+// Stream slot without a byte, SIM_IDLE in sim.h
+#define IDLE 0xFD
+
+struct board {
+	const char *mcu;
+	char pwmPort;
+	uint8_t pwmBit;
+	char pwmTimer;
+	int pwmOutput;
+	char ledPort;
+	uint8_t ledBit;
+	uint8_t audioVector;
+	uint8_t rxVector;
+};
+
+static const struct board boards[] = {
+	{ "atmega328p",  'D', 3, '2', TIMER_IRQ_OUT_PWM1, 'B', 5,  9, 18 },
+	{ "atmega328",   'D', 3, '2', TIMER_IRQ_OUT_PWM1, 'B', 5,  9, 18 },
+	{ "atmega168",   'D', 3, '2', TIMER_IRQ_OUT_PWM1, 'B', 5,  9, 18 },
+	{ "atmega8",     'B', 3, '2', TIMER_IRQ_OUT_PWM0, 'B', 5,  4, 11 },
+	{ "atmega1280",  'E', 5, '3', TIMER_IRQ_OUT_PWM2, 'B', 7, 35, 25 },
+};
+
+enum {
+	IRQ_RX,
+	IRQ_MIDI_IN,
+	IRQ_COUNT,
+};
+
+static const char *irqNames[IRQ_COUNT] = {
+	[IRQ_RX] = "rx",
+	[IRQ_MIDI_IN] = "midi_in",
+};
+
+static FILE *stream;
+static avr_irq_t *irqs;
+static avr_irq_t *uartInput;
+static unsigned long baud;
+// bits since the first slot, 10 per slot
+static uint64_t bits;
+static avr_cycle_count_t origin;
+static int frame = -1;
+static int streamEnded;
+static FILE *debugLog;
+
+static avr_cycle_count_t bitTime(avr_t *avr, uint64_t n) {
+	return origin + n * avr->frequency / baud;
+}
+
+// Start bit, 8 data bits LSB first, stop bit. The byte goes to the
+// receiver as its stop bit ends.
+static avr_cycle_count_t rxBit(avr_t *avr, avr_cycle_count_t when, void *param) {
+	uint8_t bit = bits % 10;
+
+	if (bit == 0) {
+		if (frame >= 0) {
+			avr_raise_irq(irqs + IRQ_MIDI_IN, frame);
+			avr_raise_irq(uartInput, frame);
+		}
+
+		int data = streamEnded ? EOF : getc(stream);
+
+		if (data == EOF) {
+			streamEnded = 1;
+		}
+
+		frame = data == EOF || data == IDLE ? -1 : data;
+	}
+
+	if (frame >= 0) {
+		int level = bit == 0 ? 0 : bit == 9 ? 1 : (frame >> (bit - 1)) & 1;
+		avr_raise_irq(irqs + IRQ_RX, level);
+	}
+
+	bits++;
+	return bitTime(avr, bits);
+}
+
+static void debugWrite(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+	putc(v, debugLog);
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-m mcu] [-f F_CPU] [-b baud] [-t tail] "
+		"[-o trace.vcd] [-d debug.log] [-p port] firmware song.stream\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	const char *mcu = "atmega328p";
+	const char *vcdPath = "trace.vcd";
+	const char *debugPath = NULL;
+	// DEBUGPORT in debug.h, a data space address
+	avr_io_addr_t debugPort = 0x20;
+	unsigned long frequency = 16000000;
+	double tail = 1.0;
+	int opt;
+
+	baud = 31250;
+
+	while ((opt = getopt(argc, argv, "m:f:b:t:o:d:p:")) != -1) {
+		switch (opt) {
+			// strtoul() stops at the L of 16000000L
+			case 'm': mcu = optarg; break;
+			case 'f': frequency = strtoul(optarg, NULL, 0); break;
+			case 'b': baud = strtoul(optarg, NULL, 0); break;
+			case 't': tail = atof(optarg); break;
+			case 'o': vcdPath = optarg; break;
+			case 'd': debugPath = optarg; break;
+			case 'p': debugPort = strtoul(optarg, NULL, 0); break;
+			default: usage(argv[0]);
+		}
+	}
+
+	if (argc - optind != 2) {
+		usage(argv[0]);
+	}
+
+	const struct board *board = NULL;
+
+	for (size_t i = 0; i < sizeof(boards) / sizeof(*boards); i++) {
+		if (!strcmp(boards[i].mcu, mcu)) {
+			board = &boards[i];
+		}
+	}
+
+	if (!board) {
+		fprintf(stderr, "%s: no pin map for %s\n", argv[0], mcu);
+		return 1;
+	}
+
+	elf_firmware_t firmware;
+	memset(&firmware, 0, sizeof(firmware));
+
+	if (elf_read_firmware(argv[optind], &firmware)) {
+		fprintf(stderr, "%s: cannot load %s\n", argv[0], argv[optind]);
+		return 1;
+	}
+
+	strncpy(firmware.mmcu, mcu, sizeof(firmware.mmcu) - 1);
+	firmware.frequency = frequency;
+
+	stream = !strcmp(argv[optind + 1], "-") ? stdin : fopen(argv[optind + 1], "rb");
+
+	if (!stream) {
+		perror(argv[optind + 1]);
+		return 1;
+	}
+
+	if (debugPath && !(debugLog = fopen(debugPath, "wb"))) {
+		perror(debugPath);
+		return 1;
+	}
+
+	avr_t *avr = avr_make_mcu_by_name(mcu);
+
+	if (!avr) {
+		fprintf(stderr, "%s: simavr does not know %s\n", argv[0], mcu);
+		return 1;
+	}
+
+	avr_init(avr);
+	avr_load_firmware(avr, &firmware);
+
+	irqs = avr_alloc_irq(&avr->irq_pool, 0, IRQ_COUNT, irqNames);
+	uartInput = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+	// Idle line is high
+	avr_raise_irq(irqs + IRQ_RX, 1);
+
+	if (debugLog) {
+		avr_register_io_write(avr, debugPort, debugWrite, NULL);
+	}
+
+	avr_vcd_t vcd;
+	avr_vcd_init(avr, vcdPath, &vcd, 100000);
+	avr_vcd_add_signal(&vcd,
+		avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(board->pwmPort), board->pwmBit),
+		1, "pwm");
+	avr_vcd_add_signal(&vcd,
+		avr_io_getirq(avr, AVR_IOCTL_TIMER_GETIRQ(board->pwmTimer), board->pwmOutput),
+		8, "pwm_value");
+	avr_vcd_add_signal(&vcd,
+		avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(board->ledPort), board->ledBit),
+		1, "led");
+	avr_vcd_add_signal(&vcd, irqs + IRQ_RX, 1, "rx");
+	avr_vcd_add_signal(&vcd, irqs + IRQ_MIDI_IN, 8, "midi_in");
+	avr_vcd_add_signal(&vcd,
+		avr_get_interrupt_irq(avr, board->audioVector) + AVR_INT_IRQ_RUNNING,
+		1, "audio_isr");
+	avr_vcd_add_signal(&vcd,
+		avr_get_interrupt_irq(avr, board->rxVector) + AVR_INT_IRQ_RUNNING,
+		1, "rx_isr");
+	avr_vcd_start(&vcd);
+
+	// Leave setup() some time before the first byte
+	origin = avr->frequency / 20;
+	avr_cycle_timer_register(avr, origin, rxBit, NULL);
+
+	avr_cycle_count_t stop = 0;
+	int state = cpu_Running;
+
+	while (state != cpu_Done && state != cpu_Crashed) {
+		state = avr_run(avr);
+
+		if (streamEnded && !stop) {
+			stop = avr->cycle + (avr_cycle_count_t)(tail * avr->frequency);
+		}
+		if (stop && avr->cycle >= stop) {
+			break;
+		}
+	}
+
+	avr_vcd_stop(&vcd);
+	avr_vcd_close(&vcd);
+
+	if (debugLog) {
+		fclose(debugLog);
+	}
+
+	if (state == cpu_Crashed) {
+		fprintf(stderr, "%s: firmware crashed at cycle %llu\n",
+			argv[0], (unsigned long long)avr->cycle);
+		return 1;
+	}
+
+	return 0;
+}
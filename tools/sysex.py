@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+# Auduino SysEx dump reader and writer, see include/sysex.h for the
+# message format.
+#
+# by Ilja Everilä <saarni@gmail.com>
+#
+# ChangeLog:
+# 17 Oct 2026: Initial version
+#
+# Usage:
+#   sysex.py request request.syx      write a dump request
+#   sysex.py show dump.syx            print a dump
+#   sysex.py export dump.syx out.json convert a dump to JSON
+#   sysex.py import in.json dump.syx  convert JSON back to a dump
+
+import json
+import struct
+import sys
+
+MANUFACTURER_ID = 0x7D
+MODEL_ID = 0x41
+VERSION = 1
+DUMP_REQUEST = 0x01
+DUMP = 0x02
+
+# Region id: (name, struct format, field names), keep in sync with
+# dumpRegions in src/auduino.cpp
+REGIONS = {
+    1: ("patches", "<HHBBbbBB",
+        ["grainInc1", "grainInc2", "grainDecay1", "grainDecay2",
+         "syncTranspose1", "syncTranspose2", "envDecay", "envDivider"]),
+    2: ("controllerMap", None, None),
+    3: ("channelParts", None, None),
+    # phase increments of MIDI notes 0 - 127
+    4: ("tuning", "<128H", None),
+}
+
+
+def pack7(data):
+    out = bytearray()
+    for i in range(0, len(data), 7):
+        group = data[i:i + 7]
+        out.append(sum(((b >> 7) & 1) << n for n, b in enumerate(group)))
+        out.extend(b & 0x7F for b in group)
+    return out
+
+
+def unpack7(data):
+    out = bytearray()
+    for i in range(0, len(data), 8):
+        msbs = data[i]
+        out.extend(b | ((msbs >> n) & 1) << 7
+                   for n, b in enumerate(data[i + 1:i + 8]))
+    return out
+
+
+def request():
+    return bytes([0xF0, MANUFACTURER_ID, MODEL_ID, DUMP_REQUEST, 0xF7])
+
+
+def parse(message):
+    if (len(message) < 8 or message[0] != 0xF0 or message[-1] != 0xF7
+            or message[1:4] != bytes([MANUFACTURER_ID, MODEL_ID, DUMP])):
+        raise ValueError("not an Auduino dump")
+    if message[4] != VERSION:
+        raise ValueError("unsupported version %d" % message[4])
+
+    count = message[5]
+    pos = 6
+    descriptors = []
+    for _ in range(count):
+        rid, lo, hi, items = message[pos:pos + 4]
+        descriptors.append((rid, lo | hi << 7, items))
+        pos += 4
+
+    packed = message[pos:-1]
+    if sum(packed) & 0x7F:
+        raise ValueError("checksum mismatch")
+    data = unpack7(packed[:-1])
+
+    regions = []
+    for rid, size, items in descriptors:
+        chunk, data = data[:size * items], data[size * items:]
+        if len(chunk) != size * items:
+            raise ValueError("dump cut short")
+        regions.append(decode_region(rid, size, items, chunk))
+    return regions
+
+
+def decode_region(rid, size, items, chunk):
+    name, fmt, fields = REGIONS.get(rid, ("region%d" % rid, None, None))
+    region = {"id": rid, "name": name, "size": size}
+    if fmt and struct.calcsize(fmt) == size and fields is None:
+        region["items"] = [list(struct.unpack_from(fmt, chunk, i * size))
+                           for i in range(items)]
+    elif fmt and struct.calcsize(fmt) == size:
+        region["items"] = [
+            dict(zip(fields, struct.unpack_from(fmt, chunk, i * size)))
+            for i in range(items)]
+    else:
+        region["items"] = [list(chunk[i * size:(i + 1) * size])
+                           for i in range(items)]
+    return region
+
+
+def encode_region(region):
+    rid, size = region["id"], region["size"]
+    _, fmt, fields = REGIONS.get(rid, (None, None, None))
+    data = bytearray()
+    for item in region["items"]:
+        if isinstance(item, dict):
+            data += struct.pack(fmt, *(item[f] for f in fields))
+        elif fmt and fields is None:
+            data += struct.pack(fmt, *item)
+        else:
+            data += bytes(item)
+    return rid, size, len(region["items"]), data
+
+
+def build(regions):
+    header = bytearray([0xF0, MANUFACTURER_ID, MODEL_ID, DUMP, VERSION,
+                        len(regions)])
+    data = bytearray()
+    for region in regions:
+        rid, size, items, chunk = encode_region(region)
+        header += bytes([rid, size & 0x7F, size >> 7, items])
+        data += chunk
+    packed = pack7(data)
+    return bytes(header + packed + bytes([-sum(packed) & 0x7F, 0xF7]))
+
+
+def show(regions):
+    for region in regions:
+        print("%s (id %d, %d bytes each)" % (
+            region["name"], region["id"], region["size"]))
+        for n, item in enumerate(region["items"]):
+            if isinstance(item, dict):
+                print("  %2d: %s" % (n, ", ".join(
+                    "%s=%d" % kv for kv in item.items())))
+            else:
+                print("  %2d: %s" % (n, " ".join("%d" % b for b in item)))
+
+
+def main(argv):
+    if len(argv) < 3:
+        sys.exit("usage: sysex.py request|show|export|import FILE [FILE]")
+
+    command = argv[1]
+    if command == "request":
+        with open(argv[2], "wb") as f:
+            f.write(request())
+    elif command == "show":
+        with open(argv[2], "rb") as f:
+            show(parse(f.read()))
+    elif command == "export":
+        with open(argv[2], "rb") as f:
+            regions = parse(f.read())
+        with open(argv[3], "w") as f:
+            json.dump(regions, f, indent=2)
+    elif command == "import":
+        with open(argv[2]) as f:
+            regions = json.load(f)
+        with open(argv[3], "wb") as f:
+            f.write(build(regions))
+    else:
+        sys.exit("unknown command %s" % command)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+# Auduino trace decoder, see include/trace.h for the record format.
+#
+# by Ilja Everilä <saarni@gmail.com>
+#
+# ChangeLog:
+# 17 Oct 2026: Initial version, replaces reader.py
+#
+# Usage:
+#   make DEBUG=1 simulate | trace.py [trace.h] [F_CPU]
+#
+# Prints one line per record: cycle stamp unwrapped to microseconds,
+# event name and payload. The stamps are 16bit, gaps longer than one
+# wrap (4096us at 16MHz) are not visible.
+
+import os
+import re
+import struct
+import sys
+
+RECORD = struct.Struct("<BHH")
+ENTRY = re.compile(r"^\s*(TRACE_\w+)\s*(?:=\s*(\w+))?\s*,\s*(?://\s*(.*))?$")
+
+
+def read_ids(path):
+    ids = {}
+    inside = False
+    value = 0
+    with open(path) as f:
+        for line in f:
+            if line.startswith("enum TraceId"):
+                inside = True
+                continue
+            if inside and line.startswith("}"):
+                break
+            match = inside and ENTRY.match(line)
+            if match:
+                name, explicit, comment = match.groups()
+                if explicit:
+                    value = int(explicit, 0)
+                ids[value] = (name[len("TRACE_"):].lower(), comment or "")
+                value += 1
+    return ids
+
+
+def decode(stream, ids, f_cpu):
+    cycles = 0
+    previous = None
+    while True:
+        chunk = stream.read(RECORD.size)
+        if len(chunk) < RECORD.size:
+            break
+        rid, time, data = RECORD.unpack(chunk)
+        if previous is not None:
+            cycles += (time - previous) & 0xFFFF
+        previous = time
+        name, comment = ids.get(rid, ("id%d" % rid, ""))
+        print("%12.1f us  %-14s %5d  0x%04x  %s"
+              % (cycles * 1e6 / f_cpu, name, data, data, comment))
+        sys.stdout.flush()
+
+
+def main(argv):
+    here = os.path.dirname(os.path.abspath(__file__))
+    header = argv[1] if len(argv) > 1 else \
+        os.path.join(here, "..", "include", "trace.h")
+    f_cpu = float(argv[2]) if len(argv) > 2 else 16e6
+    decode(sys.stdin.buffer, read_ids(header), f_cpu)
+
+
+if __name__ == "__main__":
+    main(sys.argv)